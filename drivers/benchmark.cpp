@@ -0,0 +1,103 @@
+// Compare plain counts with Rao-Blackwellized estimates by effective draws per
+// second
+
+#include "Simulator.h"
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// usage:
+// $ make DRIVER=benchmark
+// $ ./bin/benchmark <year> <ucl | uel | uecl> <iterations> [<teams csv path>]
+//   [--seed <seed>] [--threads <n>]
+// - simulates the same draws (same seed) with each estimator, writing
+//   `results/benchmark_<competition>_<year>_<iterations>_<estimator>.csv`
+// - effective draws/s: draws/s * (per-draw variance of plain counts / that of
+//   the estimator), summed over pairs
+
+int main(int argc, char **argv) {
+    std::vector<std::string> args;
+    SimulatorOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            args.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            exit(1);
+        }
+        std::string value = argv[++i];
+        if (arg == "--seed") {
+            options.seed = std::stoull(value);
+        } else if (arg == "--threads") {
+            options.threads = std::stoi(value);
+            if (options.threads < 0) {
+                std::cerr << "Invalid thread count: must be >= 0" << std::endl;
+                exit(1);
+            }
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            exit(1);
+        }
+    }
+
+    if (args.size() < 3 || args.size() > 4) {
+        std::cerr << "Usage: ./bin/benchmark <year> <ucl | uel | uecl> "
+                     "<iterations> [<teams csv path>] [--seed <seed>] "
+                     "[--threads <n>]"
+                  << std::endl;
+        exit(1);
+    }
+    int year = std::stoi(args[0]);
+    std::string competition = args[1];
+    int iterations = std::stoi(args[2]);
+    std::string teamsPath = args.size() >= 4 ? args[3] : "";
+    if (competition != "ucl" && competition != "uel" && competition != "uecl") {
+        std::cerr << "Invalid competition type: must be 'ucl', 'uel', or 'uecl'"
+                  << std::endl;
+        exit(1);
+    }
+    if (iterations < 1) {
+        std::cerr << "Invalid iterations: must be >= 1" << std::endl;
+        exit(1);
+    }
+    if (!options.seed) {
+        options.seed =
+            (uint64_t{std::random_device{}()} << 32) | std::random_device{}();
+    }
+    // benchmark runs are short, so they aren't checkpointed
+    options.checkpointSeconds = 0;
+
+    Simulator s(year, competition, teamsPath);
+    std::vector<SimulatorStats> stats;
+    for (bool raoBlackwell : {false, true}) {
+        options.raoBlackwell = raoBlackwell;
+        std::string output = "results/benchmark_" + competition + "_" +
+                             std::to_string(year) + "_" +
+                             std::to_string(iterations) + "_" +
+                             (raoBlackwell ? "rb" : "plain") + ".csv";
+        stats.push_back(s.run(iterations, output, options));
+        std::cout << std::endl;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "estimator  draws/s  variance reduction  effective draws/s"
+              << std::endl;
+    std::vector<double> effective;
+    for (size_t k = 0; k < stats.size(); k++) {
+        double rate = stats[k].draws / stats[k].seconds;
+        effective.push_back(rate * stats[k].varianceReduction);
+        std::cout << std::left << std::setw(11) << (k ? "rb" : "plain")
+                  << std::right << std::setw(7) << rate << std::setw(20)
+                  << stats[k].varianceReduction << std::setw(19)
+                  << effective.back() << std::endl;
+    }
+    std::cout << "rb vs plain: " << effective[1] / effective[0]
+              << "x effective draws/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,30 @@
+// Convert a binary results file to a results csv
+
+#include "Results.h"
+#include <filesystem>
+#include <iostream>
+
+// usage:
+// $ make DRIVER=convert
+// $ ./bin/convert <results bin path> <output results csv path>
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: ./bin/convert <results bin path> <output csv path>"
+                  << std::endl;
+        exit(1);
+    }
+
+    PartialResults results = readBinaryResults(argv[1]);
+    if (results.header.numShards > 1) {
+        std::cerr << "Cannot convert shard " << results.header.shard << "/"
+                  << results.header.numShards << " on its own: use ./bin/merge"
+                  << std::endl;
+        exit(1);
+    }
+
+    std::filesystem::path outputPath = argv[2];
+    writeResults(results.counts, results.header, outputPath);
+    std::cout << "Wrote results to " << outputPath.string() << "." << std::endl;
+    return 0;
+}
@@ -2,19 +2,119 @@
 
 #include "Draw.h"
 #include "Simulator.h"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
 #include <iostream>
 #include <string>
+#include <vector>
 
 // usage:
 // $ make all
 // $ ./bin/main <year> <ucl | uel | uecl> <iterations> [<teams csv path>
-//   <output csv path>]
+//   <output csv path>] [--cache-mb <MB>] [--expand-nodes <n>]
+//   [--nested-nodes <n>] [--timeout-nodes <n>] [--restart-nodes <n>]
+//   [--timeout-ms <ms>] [--seed <seed>] [--threads <n>] [--shard <k>/<N>]
+//   [--draw-log <log bin path>] [--checkpoint-secs <s>]
+//   [--resume <checkpoint path>] [--target-ci <pp>] [--batch-draws <n>]
+//   [--estimator <plain | rb>]
 
 int main(int argc, char **argv) {
-    if (argc > 5) {
+    // split args into positional args and `--<name> <value>` options
+    std::vector<std::string> args;
+    SimulatorOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            args.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            exit(1);
+        }
+        std::string value = argv[++i];
+        if (arg == "--cache-mb") {
+            options.cacheMB = std::stoi(value);
+            if (options.cacheMB < 0) {
+                std::cerr << "Invalid cache size: must be >= 0" << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--expand-nodes") {
+            options.dfsBudget.expandNodes = std::stoull(value);
+        } else if (arg == "--nested-nodes") {
+            options.dfsBudget.nestedNodes = std::stoull(value);
+            if (options.dfsBudget.nestedNodes < 1) {
+                std::cerr << "Invalid node budget: --nested-nodes must be >= 1"
+                          << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--timeout-nodes") {
+            options.dfsBudget.timeoutNodes = std::stoull(value);
+        } else if (arg == "--restart-nodes") {
+            options.dfsBudget.restartNodes = std::stoull(value);
+        } else if (arg == "--timeout-ms") {
+            options.dfsBudget.timeout =
+                std::chrono::milliseconds(std::stoll(value));
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(value);
+        } else if (arg == "--threads") {
+            options.threads = std::stoi(value);
+            if (options.threads < 0) {
+                std::cerr << "Invalid thread count: must be >= 0" << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--shard") {
+            size_t slash = value.find('/');
+            if (slash == std::string::npos) {
+                std::cerr << "Invalid shard: must be <k>/<N>" << std::endl;
+                exit(1);
+            }
+            options.shard = std::stoi(value.substr(0, slash));
+            options.numShards = std::stoi(value.substr(slash + 1));
+            if (options.numShards < 1 || options.shard < 0 ||
+                options.shard >= options.numShards) {
+                std::cerr << "Invalid shard: must have 0 <= k < N" << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--draw-log") {
+            options.drawLog = value;
+        } else if (arg == "--checkpoint-secs") {
+            options.checkpointSeconds = std::stoi(value);
+        } else if (arg == "--resume") {
+            options.resume = value;
+        } else if (arg == "--target-ci") {
+            options.targetCI = std::stod(value);
+        } else if (arg == "--batch-draws") {
+            options.batchDraws = std::stoi(value);
+            if (options.batchDraws < 1) {
+                std::cerr << "Invalid batch size: must be >= 1" << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--estimator") {
+            if (value != "plain" && value != "rb") {
+                std::cerr << "Invalid estimator: must be 'plain' or 'rb'"
+                          << std::endl;
+                exit(1);
+            }
+            options.raoBlackwell = value == "rb";
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            exit(1);
+        }
+    }
+
+    if (options.dfsBudget.timeoutNodes <= options.dfsBudget.expandNodes) {
+        std::cerr << "Invalid node budgets: --timeout-nodes must be > "
+                     "--expand-nodes"
+                  << std::endl;
+        exit(1);
+    }
+
+    if (args.size() > 5) {
         std::cerr << "Too many arguments" << std::endl;
         exit(1);
-    } else if (argc < 3) {
+    } else if (args.size() < 2) {
         std::cerr << "Missing arguments" << std::endl;
         exit(1);
     }
@@ -22,17 +122,45 @@ int main(int argc, char **argv) {
     int iterations = 1;
     std::string teamsPath = "";
     std::string output = "";
-    int year = std::stoi(argv[1]);
-    std::string competition = argv[2];
+    int year = std::stoi(args[0]);
+    std::string competition = args[1];
 
-    if (argc >= 4) {
-        iterations = std::stoi(argv[3]);
+    if (args.size() >= 3) {
+        iterations = std::stoi(args[2]);
     }
-    if (argc >= 5) {
-        teamsPath = argv[4];
+    if (args.size() >= 4) {
+        teamsPath = args[3];
+    }
+    if (args.size() >= 5) {
+        output = args[4];
+    }
+
+    if (options.numShards > 1 && !options.seed) {
+        std::cerr << "Missing --seed: shards of a run must share a seed"
+                  << std::endl;
+        exit(1);
     }
-    if (argc >= 6) {
-        output = argv[5];
+
+    if (!options.resume.empty() && !options.drawLog.empty()) {
+        std::cerr << "--draw-log can't be combined with --resume" << std::endl;
+        exit(1);
+    }
+
+    if (options.targetCI > 0 &&
+        (options.numShards > 1 || !options.resume.empty())) {
+        std::cerr << "--target-ci can't be combined with --shard or --resume"
+                  << std::endl;
+        exit(1);
+    }
+
+    // Rao-Blackwellized estimates are only written to csv results
+    if (options.raoBlackwell &&
+        (options.numShards > 1 || !options.resume.empty() ||
+         std::filesystem::path(output).extension() == ".bin")) {
+        std::cerr << "--estimator rb can't be combined with --shard, --resume "
+                     "or binary output"
+                  << std::endl;
+        exit(1);
     }
 
     if (year <= 0) {
@@ -47,6 +175,6 @@ int main(int argc, char **argv) {
     }
 
     Simulator s(year, competition, teamsPath);
-    s.run(iterations, output);
+    s.run(iterations, output, options);
     return 0;
 }
@@ -0,0 +1,42 @@
+// Merge binary partial results of a sharded run into a results csv (or binary
+// results file, if the output path ends in .bin)
+
+#include "Results.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// usage:
+// $ make DRIVER=merge
+// $ ./bin/merge <output results path> <partial results bin path>...
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: ./bin/merge <output results path> <partial "
+                     "results bin path>..."
+                  << std::endl;
+        exit(1);
+    }
+
+    std::filesystem::path outputPath = argv[1];
+    std::vector<PartialResults> shards;
+    for (int i = 2; i < argc; i++) {
+        shards.push_back(readBinaryResults(argv[i]));
+    }
+
+    PartialResults merged = mergePartialResults(shards);
+    merged.header.timestamp = std::chrono::system_clock::now();
+    if (outputPath.extension() == ".bin") {
+        writeBinaryResults(merged, outputPath);
+    } else {
+        writeResults(merged.counts, merged.header, outputPath);
+    }
+
+    std::cout << "Merged " << shards.size() << " shards ("
+              << merged.header.iterations << " simulations, seed "
+              << merged.header.seed << ")." << std::endl;
+    std::cout << "Wrote results to " << outputPath.string() << "." << std::endl;
+    return 0;
+}
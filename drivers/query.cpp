@@ -0,0 +1,211 @@
+// Conditional matchup probabilities over a draw log
+
+#include "CountMatrix.h"
+#include "DrawIndex.h"
+#include "Results.h"
+#include "globals.h"
+#include "utils.h"
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// usage:
+// $ make DRIVER=query
+// $ ./bin/query <draw log bin path> [<home team abbrev>-<away team abbrev>...]
+//   [--team <abbrev>] [--teams <teams csv path>] [--output <results csv path>]
+// - with no games, reads one query (space-separated games) per line of stdin,
+//   reusing the index; --output then writes `<stem>_<query #><ext>` per query
+// - no results csv is written for a query no draw matches
+
+namespace {
+
+std::unordered_map<std::string, int> teamIndexByAbbrev;
+
+// parse `<home abbrev>-<away abbrev>`; returns false if invalid
+bool parseGame(const std::string &s, Game &g) {
+    size_t pos = s.find('-');
+    if (pos == std::string::npos) {
+        return false;
+    }
+    auto h = teamIndexByAbbrev.find(trim(s.substr(0, pos)));
+    auto a = teamIndexByAbbrev.find(trim(s.substr(pos + 1)));
+    if (h == teamIndexByAbbrev.end() || a == teamIndexByAbbrev.end()) {
+        return false;
+    }
+    g = Game(h->second, a->second);
+    return true;
+}
+
+// print matchup probabilities among the selected draws, of one team's
+// opponents (team >= 0) or of all pairs
+void printProbabilities(const DrawIndex &index, const CountMatrix &counts,
+                        size_t matches, const std::vector<Team> &teams,
+                        int team) {
+    std::cout << matches << " of " << index.numDraws() << " draws match"
+              << std::endl;
+    if (!matches) {
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(2);
+    for (int i = 0; i < index.numTeams() - 1; i++) {
+        for (int j = i + 1; j < index.numTeams(); j++) {
+            if (team >= 0 && i != team && j != team) {
+                continue;
+            }
+            int home = counts.get(i, j);
+            int away = counts.get(j, i);
+            if (!home && !away) {
+                continue;
+            }
+            std::cout << "  " << teams[i].abbrev << " vs " << teams[j].abbrev
+                      << ": " << 100.0 * (home + away) / matches << "% (home "
+                      << 100.0 * home / matches << "%, away "
+                      << 100.0 * away / matches << "%)" << std::endl;
+        }
+    }
+    std::cout.unsetf(std::ios::fixed);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::vector<std::string> args;
+    std::string teamAbbrev = "";
+    std::string teamsPath = "";
+    std::string output = "";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            args.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            exit(1);
+        }
+        std::string value = argv[++i];
+        if (arg == "--team") {
+            teamAbbrev = value;
+        } else if (arg == "--teams") {
+            teamsPath = value;
+        } else if (arg == "--output") {
+            output = value;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            exit(1);
+        }
+    }
+
+    if (args.empty()) {
+        std::cerr << "Usage: ./bin/query <draw log path> [<games>...]"
+                  << std::endl;
+        exit(1);
+    }
+
+    MappedResults log(args[0]);
+    const ResultsFileHeader &fh = log.header();
+    ResultsHeader header = makeResultsHeader(fh);
+
+    std::vector<Team> teams = readCSVTeams(
+        teamsPath != "" ? teamsPath
+                        : "data/" + std::to_string(header.year) + "/" +
+                              header.competition + "/teams.csv");
+    if (teams.size() != fh.numTeams) {
+        std::cerr << "Teams csv has " << teams.size()
+                  << " teams, but the draw log has " << fh.numTeams
+                  << std::endl;
+        exit(1);
+    }
+    for (size_t i = 0; i < teams.size(); i++) {
+        teamIndexByAbbrev[teams[i].abbrev] = static_cast<int>(i);
+    }
+    int team = -1;
+    if (teamAbbrev != "") {
+        if (!teamIndexByAbbrev.count(teamAbbrev)) {
+            std::cerr << "Unknown team: " << teamAbbrev << std::endl;
+            exit(1);
+        }
+        team = teamIndexByAbbrev[teamAbbrev];
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    DrawIndex index(log);
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout << "Indexed " << index.numDraws() << " draws in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(t1 -
+                                                                       t0)
+                     .count()
+              << " ms" << std::endl;
+
+    // answer one query given as args, or one per line of stdin
+    std::vector<std::string> queries;
+    bool fromStdin = args.size() == 1;
+    if (!fromStdin) {
+        std::string query;
+        for (size_t i = 1; i < args.size(); i++) {
+            query += args[i] + " ";
+        }
+        queries.push_back(query);
+    }
+    std::string line;
+    int queryNumber = 0; // 1-based, counting invalid queries too
+    while (fromStdin ? static_cast<bool>(std::getline(std::cin, line))
+                     : !queries.empty()) {
+        std::string query = fromStdin ? line : queries.back();
+        queries.clear();
+        queryNumber++;
+
+        std::vector<Game> games;
+        std::stringstream ss(query);
+        std::string token;
+        bool valid = true;
+        while (ss >> token) {
+            Game g;
+            if (!parseGame(token, g)) {
+                std::cerr << "Invalid game: " << token << std::endl;
+                valid = false;
+                break;
+            }
+            games.push_back(g);
+        }
+        if (!valid) {
+            continue;
+        }
+
+        auto q0 = std::chrono::steady_clock::now();
+        std::vector<uint64_t> selection = index.select(games);
+        size_t matches = DrawIndex::count(selection);
+        CountMatrix counts = index.countGames(selection);
+        auto q1 = std::chrono::steady_clock::now();
+        printProbabilities(index, counts, matches, teams, team);
+        std::cout << "Answered in "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(
+                         q1 - q0)
+                             .count() /
+                         1000.0
+                  << " ms" << std::endl;
+
+        if (output != "" && matches > 0) {
+            // conditional results, in the usual results csv format (one file
+            // per stdin query, so later queries don't overwrite earlier ones)
+            std::filesystem::path outputPath = output;
+            if (fromStdin) {
+                outputPath.replace_filename(
+                    outputPath.stem().string() + "_" +
+                    std::to_string(queryNumber) +
+                    outputPath.extension().string());
+            }
+            header.iterations = static_cast<int>(matches);
+            header.timestamp = std::chrono::system_clock::now();
+            writeResults(counts, header, outputPath);
+            std::cout << "Wrote results to " << outputPath.string() << "."
+                      << std::endl;
+        }
+    }
+    return 0;
+}
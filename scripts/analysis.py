@@ -2,7 +2,7 @@
 Generate heatmap visualization.
 
 Usage:
-$ python analysis.py <path to results csv>
+$ python analysis.py <path to results csv or bin>
 
 Visualization will be placed in
 `results/<competition>_<year>_<iterations>_<YYYYMMDD>_<HHMMSS>.png`.
@@ -97,6 +97,79 @@ def parse_csv(path: str) -> tuple[dict[str, Value], list[dict[str, Value]]]:
     return frontmatter, data
 
 
+# binary results file layout (see `src/Results.h`)
+RESULTS_MAGIC = b"DRAWRES\0"
+RESULTS_VERSION = 1
+RESULTS_HEADER_DTYPE = np.dtype(
+    [
+        ("magic", "S8"),
+        ("version", "<u4"),
+        ("num_teams", "<u4"),
+        ("competition", "S8"),
+        ("year", "<i4"),
+        ("num_sections", "<u4"),
+        ("iterations", "<u8"),
+        ("seed", "<u8"),
+        ("scenario_hash", "<u8"),
+        ("shard", "<u4"),
+        ("num_shards", "<u4"),
+        ("timestamp", "<i8"),
+        ("reserved", "V56"),
+    ]
+)
+RESULTS_SECTION_DTYPE = np.dtype(
+    [("kind", "<u4"), ("reserved", "<u4"), ("bytes", "<u8")]
+)
+COUNTS_SECTION = 1
+
+
+def parse_bin(path: str) -> tuple[dict[str, Value], np.ndarray]:
+    """Memory-map binary results file.
+
+    Args:
+        path (str): path to binary results file
+
+    Returns:
+        tuple[dict[str, Value], np.ndarray]: (frontmatter dict, read-only
+        num_teams x num_teams array of counts, where entry [h, a] is the number
+        of draws with home team h and away team a)
+    """
+    header = np.memmap(path, dtype=RESULTS_HEADER_DTYPE, mode="r", shape=(1,))[0]
+    if bytes(header["magic"]) != RESULTS_MAGIC.rstrip(b"\0"):
+        raise ValueError(f"{path} is not a binary results file")
+    if header["version"] != RESULTS_VERSION:
+        raise ValueError(f"{path} has unsupported version {header['version']}")
+    if header["num_shards"] > 1:
+        raise ValueError(f"{path} is a single shard: merge shards first")
+
+    frontmatter: dict[str, Value] = {
+        "timestamp": datetime.datetime.fromtimestamp(int(header["timestamp"])),
+        "competition": header["competition"].decode(),
+        "year": int(header["year"]),
+        "simulations": int(header["iterations"]),
+        "seed": int(header["seed"]),
+    }
+
+    num_teams = int(header["num_teams"])
+    offset = RESULTS_HEADER_DTYPE.itemsize
+    for _ in range(int(header["num_sections"])):
+        section = np.memmap(
+            path, dtype=RESULTS_SECTION_DTYPE, mode="r", offset=offset, shape=(1,)
+        )[0]
+        offset += RESULTS_SECTION_DTYPE.itemsize
+        if section["kind"] == COUNTS_SECTION:
+            counts = np.memmap(
+                path,
+                dtype="<i4",
+                mode="r",
+                offset=offset,
+                shape=(num_teams, num_teams),
+            )
+            return frontmatter, counts
+        offset += (int(section["bytes"]) + 15) // 16 * 16
+    raise ValueError(f"{path} has no counts section")
+
+
 def get_team_logo(team_id: str, force_refresh: bool = False) -> Image.Image:
     """Retrieve image of team logo from `CACHE_DIR` or UEFA website.
 
@@ -296,7 +369,10 @@ def main():
     parser.add_argument("path", type=str)
     args = parser.parse_args()
 
-    frontmatter, data = parse_csv(args.path)
+    if args.path.endswith(".bin"):
+        frontmatter, counts = parse_bin(args.path)
+    else:
+        frontmatter, data = parse_csv(args.path)
     competition = Competition(frontmatter["competition"])
     year = cast(int, frontmatter["year"])
     iterations = cast(int, frontmatter["simulations"])
@@ -309,12 +385,16 @@ def main():
 
     probs = np.zeros((num_teams, num_teams))
 
-    for row in data:
-        t1 = cast(int, row["t1"])
-        t2 = cast(int, row["t2"])
-        total = cast(int, row["total"])
-        probs[t1][t2] = (total / iterations) * 100
-        probs[t2][t1] = (total / iterations) * 100
+    if args.path.endswith(".bin"):
+        probs = ((counts + counts.T) / iterations) * 100
+    else:
+        for row in data:
+            t1 = cast(int, row["t1"])
+            t2 = cast(int, row["t2"])
+            # Rao-Blackwellized estimate, if the run has one
+            total = cast(float, row.get("total_rb", row["total"]))
+            probs[t1][t2] = (total / iterations) * 100
+            probs[t2][t1] = (total / iterations) * 100
 
     fig, ax = plt.subplots(figsize=(10, 8), dpi=300)
 
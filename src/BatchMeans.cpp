@@ -0,0 +1,87 @@
+#include "BatchMeans.h"
+#include "CountMatrix.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+BatchMeans::BatchMeans(int numTeams)
+    : teams(numTeams), previous(numTeams * numTeams, 0),
+      gameCountSqs(numTeams * numTeams, 0),
+      gameWeighted(numTeams * numTeams, 0),
+      pairCountSqs(numTeams * numTeams, 0),
+      pairWeighted(numTeams * numTeams, 0) {}
+
+void BatchMeans::addBatch(const CountMatrix &totals, int batchDraws) {
+    std::vector<int> batch(teams * teams);
+    for (int h = 0; h < teams; h++) {
+        for (int a = 0; a < teams; a++) {
+            int cell = h * teams + a;
+            batch[cell] = totals.get(h, a) - previous[cell];
+            previous[cell] = totals.get(h, a);
+            double count = batch[cell];
+            gameCountSqs[cell] += count * count;
+            gameWeighted[cell] += count * batchDraws;
+        }
+    }
+    for (int i = 0; i < teams - 1; i++) {
+        for (int j = i + 1; j < teams; j++) {
+            double count = batch[i * teams + j] + batch[j * teams + i];
+            pairCountSqs[i * teams + j] += count * count;
+            pairWeighted[i * teams + j] += count * batchDraws;
+        }
+    }
+    draws += batchDraws;
+    drawsSq += static_cast<double>(batchDraws) * batchDraws;
+    batches++;
+}
+
+int BatchMeans::numBatches() const { return batches; }
+
+double BatchMeans::gameHalfWidth(int h, int a, double z) const {
+    int cell = h * teams + a;
+    return halfWidth(previous[cell], gameCountSqs[cell], gameWeighted[cell],
+                     z);
+}
+
+double BatchMeans::pairHalfWidth(int i, int j, double z) const {
+    int cell = std::min(i, j) * teams + std::max(i, j);
+    return halfWidth(previous[i * teams + j] + previous[j * teams + i],
+                     pairCountSqs[cell], pairWeighted[cell], z);
+}
+
+double BatchMeans::maxPairHalfWidth(double z) const {
+    double worst = 0;
+    for (int i = 0; i < teams - 1; i++) {
+        for (int j = i + 1; j < teams; j++) {
+            worst = std::max(worst, pairHalfWidth(i, j, z));
+        }
+    }
+    return worst;
+}
+
+double BatchMeans::halfWidth(double count, double countSq, double weighted,
+                             double z) const {
+    if (batches < 2) {
+        return 0;
+    }
+    // variance of the estimate p = count / draws from the spread of batch
+    // means around it, weighted by batch size: sum of (batch count - p *
+    // batch size)^2, over draws^2, with the usual batches / (batches - 1)
+    // correction (equal batches give sample variance of batch means / batches)
+    double p = count / draws;
+    double spread =
+        std::max(0.0, countSq - 2 * p * weighted + p * p * drawsSq);
+    double variance = spread / (draws * draws) * batches / (batches - 1);
+    double batchHalfWidth = z * std::sqrt(variance);
+
+    // distance from p to the farther end of its Wilson score interval (for
+    // p = 0, about z^2 / draws, like the rule of three)
+    double z2 = z * z;
+    double center = (p + z2 / (2 * draws)) / (1 + z2 / draws);
+    double radius =
+        z * std::sqrt(p * (1 - p) / draws + z2 / (4 * draws * draws)) /
+        (1 + z2 / draws);
+    double wilsonHalfWidth =
+        std::max(center + radius - p, p - (center - radius));
+    return std::max(batchHalfWidth, wilsonHalfWidth);
+}
@@ -0,0 +1,47 @@
+#ifndef BATCH_MEANS_H
+#define BATCH_MEANS_H
+
+#include "CountMatrix.h"
+#include <vector>
+
+// z of a two-sided 95% confidence interval
+constexpr double CI_95_Z = 1.959964;
+
+// confidence intervals of every game's and team pair's probability, from the
+// means of batches of draws (batch means are close to normal even when single
+// draws are not, and need only running sums per entry)
+// - batches are weighted by their # draws, so a short last batch doesn't bias
+//   the estimate
+// - half-widths are at least those of the Wilson score interval of the counts,
+//   so a rare game seen in no batch doesn't get a 0 half-width
+class BatchMeans {
+  public:
+    explicit BatchMeans(int numTeams);
+
+    // fold in the batch of draws counted in totals since the last call
+    void addBatch(const CountMatrix &totals, int batchDraws);
+    int numBatches() const;
+
+    // half-widths of confidence intervals (in probability) at z; 0 if fewer
+    // than 2 batches
+    double gameHalfWidth(int h, int a, double z) const; // game h-a
+    double pairHalfWidth(int i, int j, double z) const; // i-j or j-i
+    double maxPairHalfWidth(double z) const;
+
+  private:
+    double halfWidth(double count, double countSq, double weighted,
+                     double z) const;
+
+    int teams;
+    int batches = 0;
+    double draws = 0;       // over all batches
+    double drawsSq = 0;     // sum of squared batch sizes
+    std::vector<int> previous; // totals as of the last batch
+    // sums over batches of squared batch counts and of batch counts times
+    // batch sizes, per game (h * teams + a) and per pair (i * teams + j,
+    // i < j)
+    std::vector<double> gameCountSqs, gameWeighted;
+    std::vector<double> pairCountSqs, pairWeighted;
+};
+
+#endif // BATCH_MEANS_H
@@ -0,0 +1,52 @@
+#ifndef COUNT_MATRIX_H
+#define COUNT_MATRIX_H
+
+#include "globals.h"
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// dense numTeams x numTeams matrix of game counts (entry h * numTeams + a =
+// # draws with game h-a), with one slice per worker
+// - each slice starts on its own cache line, so workers counting concurrently
+//   never share lines
+// - slices are contiguous int arrays, so merging them is a vectorized sum
+class CountMatrix {
+  public:
+    explicit CountMatrix(int numTeams, int numSlices = 1);
+
+    int numTeams() const;
+    int numSlices() const;
+
+    void add(int slice, const Game &g) {
+        data[slice * stride + g.h * teams + g.a]++;
+    }
+    void add(int slice, const std::vector<Game> &games);
+    void add(int slice, int h, int a, int n) {
+        data[slice * stride + h * teams + a] += n;
+    }
+    int get(int h, int a, int slice = 0) const {
+        return data[slice * stride + h * teams + a];
+    }
+
+    // add slice fromSlice of from (same # teams) to slice
+    void addSlice(int slice, const CountMatrix &from, int fromSlice);
+
+    // sum of all slices, as a single slice matrix
+    CountMatrix reduce() const;
+
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct FreeDeleter {
+        void operator()(int *p) const { std::free(p); }
+    };
+
+    int teams;
+    int slices;
+    size_t stride; // # ints per slice, rounded up to whole cache lines
+    std::unique_ptr<int[], FreeDeleter> data;
+};
+
+#endif // COUNT_MATRIX_H
@@ -1,11 +1,15 @@
 #include "Draw.h"
+#include "FeasibilityCache.h"
+#include "PhiloxEngine.h"
+#include "PortfolioStats.h"
+#include "Scheduler.h"
+#include "allocations.h"
 #include "globals.h"
 #include "utils.h"
-#include <BS_thread_pool/BS_thread_pool.hpp>
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
-#include <future>
 #include <iostream>
 #include <numeric>
 #include <random>
@@ -15,67 +19,321 @@
 
 const std::string POT_COLORS[] = {RED, BLUE, GREEN, YELLOW, CYAN, MAGENTA};
 
-Draw::Draw(const std::vector<Team> &t, const std::vector<Game> &initialGames,
-           const std::unordered_set<std::string> &bannedCountryMatchups,
-           int pots, int teamsPerPot, int gamesPerTeam, int gamesPerPotPair,
-           bool s)
+Draw::Draw(std::shared_ptr<const DrawScenario> sc, int pots, int teamsPerPot,
+           int gamesPerTeam, int gamesPerPotPair, bool s)
     : numPots(pots), numTeamsPerPot(teamsPerPot), numGamesPerTeam(gamesPerTeam),
       numTeams(numPots * numTeamsPerPot), numGamesPerPotPair(gamesPerPotPair),
-      suppress(s), teams(t), randomEngine(std::random_device{}()) {
-    initializeState(initialGames, bannedCountryMatchups);
+      suppress(s), scenario(std::move(sc)), teams(scenario->teams),
+      countries(scenario->countries), teamCountryIds(scenario->teamCountryIds),
+      numTeamsByCountry(scenario->numTeamsByCountry),
+      teamIndsByCountry(scenario->teamIndsByCountry),
+      teamsByPot(scenario->teamsByPot),
+      teamsByCountry(scenario->teamsByCountry),
+      legalOppsByTeamInd(scenario->legalOppsByTeamInd),
+      randomKey((uint64_t{std::random_device{}()} << 32) |
+                std::random_device{}()),
+      randomEngine(randomKey) {}
+
+void Draw::setFeasibilityCache(FeasibilityCache *cache) {
+    feasibilityCache = cache;
+    ownedFeasibilityCache.reset();
 }
 
-Draw::Draw(std::string teamsPath, std::string initialGamesPath,
-           std::string bannedCountryMatchupsPath, int pots, int teamsPerPot,
-           int gamesPerTeam, int gamesPerPotPair, bool s)
-    : numPots(pots), numTeamsPerPot(teamsPerPot), numGamesPerTeam(gamesPerTeam),
-      numTeams(numPots * numTeamsPerPot), numGamesPerPotPair(gamesPerPotPair),
-      suppress(s), teams(readCSVTeams(teamsPath)),
-      randomEngine(std::random_device{}()) {
-    initializeState(initialGamesPath != ""
-                        ? readTXTGames(initialGamesPath, teams)
-                        : std::vector<Game>(),
-                    bannedCountryMatchupsPath != ""
-                        ? readTXTCountries(bannedCountryMatchupsPath)
-                        : std::unordered_set<std::string>());
+void Draw::setPortfolioStats(PortfolioStats *stats) {
+    portfolioStats = stats;
+    ownedPortfolioStats.reset();
+}
+
+void Draw::setDFSBudget(const DFSBudget &budget) { dfsBudget = budget; }
+
+void Draw::setRandomStream(uint64_t key, uint64_t stream) {
+    randomKey = key;
+    randomStream = stream;
+    randomEngine.seed(randomKey, randomStream);
+}
+
+void Draw::setPickCredits(bool enabled) {
+    creditPicks = enabled;
+    pickCredits.assign(enabled ? numTeams * numTeams : 0, 0.0);
+}
+
+const std::vector<double> &Draw::getPickCredits() const { return pickCredits; }
+
+void Draw::initializeFeasibilityCache() {
+    // default to a draw-local cache (64K slots), which reset keeps, so a
+    // reused draw (e.g. a Simulator worker's) keeps it across its draws
+    if (!feasibilityCache) {
+        ownedFeasibilityCache = std::make_unique<FeasibilityCache>(16);
+        feasibilityCache = ownedFeasibilityCache.get();
+    }
+}
+
+void Draw::initializePortfolioStats() {
+    if (!portfolioStats) {
+        ownedPortfolioStats = std::make_unique<PortfolioStats>();
+        portfolioStats = ownedPortfolioStats.get();
+    }
+}
+
+const std::vector<Game> Draw::getPickedGames() const {
+    return pickedGames;
+}
+
+int Draw::numGamesAgainstCountry(int teamIndex, int country,
+                                 const DFSContext &context) const {
+    return ((context.facedCountriesByTeamInd[teamIndex] >> country) & 1) +
+           ((context.maxedTeamsByCountry[country] >> teamIndex) & 1);
+}
+
+void Draw::displayPots(bool showCountries) const {
+    std::cout << "Games: " << pickedGames.size() << std::endl
+              << std::endl;
+
+    for (int i = 0; i < numPots; i++) {
+        std::cout << POT_COLORS[i] << "Pot " << i + 1 << RESET << std::endl;
+        for (int j = 0; j < numTeamsPerPot; j++) {
+            int teamInd = i * numTeamsPerPot + j;
+            std::cout << teams[teamInd].abbrev;
+            if (showCountries) {
+                std::cout << GRAY << "(" << toLower(teams[teamInd].country)
+                          << ")" << RESET;
+            }
+            std::cout << "\t";
+            std::vector<Game> teamGames = gamesByTeamInd.at(teamInd);
+            std::stable_sort(teamGames.begin(), teamGames.end(),
+                             [this, teamInd](const Game &g1, const Game &g2) {
+                                 // order by opponent pot
+                                 int oppInd1 = (g1.h == teamInd) ? g1.a : g1.h;
+                                 int oppInd2 = (g2.h == teamInd) ? g2.a : g2.h;
+                                 return teams[oppInd1].pot < teams[oppInd2].pot;
+                             });
+            for (size_t k = 0; k < teamGames.size(); k++) {
+                Game g = teamGames[k];
+                int oppInd = (g.h == teamInd) ? g.a : g.h;
+                std::cout << POT_COLORS[teams[oppInd].pot - 1]
+                          << teams[oppInd].abbrev << RESET;
+                if (showCountries) {
+                    std::cout << GRAY << "(" << toLower(teams[oppInd].country)
+                              << "."
+                              << numGamesAgainstCountry(
+                                     teamInd, teamCountryIds[oppInd], state)
+                              << ")" << RESET;
+                }
+                std::cout << ((g.h == teamInd) ? "h" : "a");
+                if (k < teamGames.size() - 1) {
+                    std::cout << ",";
+                }
+            }
+            std::cout << std::endl;
+        }
+        std::cout << std::endl;
+    }
 }
 
-void Draw::initializeState(
-    const std::vector<Game> &initialGames,
+bool Draw::verifyDraw() const {
+    // check for correct total number of games
+    size_t numExpectedGames = numTeams * numGamesPerTeam / 2;
+    if (pickedGames.size() != numExpectedGames) {
+        if (!suppress)
+            std::cout << "INVALID DRAW: drew " << pickedGames.size()
+                      << " games but expected " << numExpectedGames << "."
+                      << std::endl;
+        return false;
+    }
+
+    std::unordered_map<int, TeamVerifier> m; // team ind -> TeamVerifier
+    for (const Game &g : pickedGames) {
+        // check for no opp from own country
+        if (teams[g.h].country == teams[g.a].country) {
+            if (!suppress)
+                std::cout << "INVALID DRAW: same country ("
+                          << teams[g.h].country << ")- " << teams[g.h].abbrev
+                          << " has been drawn against " << teams[g.a].abbrev
+                          << "." << std::endl;
+            return false;
+        }
+        m[g.h].oppTeamInds.insert(g.a);
+        m[g.h].numGamesByPot[teams[g.a].pot] += 1;
+        m[g.a].oppTeamInds.insert(g.h);
+        m[g.a].numGamesByPot[teams[g.h].pot] += 1;
+
+        // check for no more than 2 opps from same country
+        m[g.h].numOppsByCountry[teams[g.a].country] += 1;
+        m[g.a].numOppsByCountry[teams[g.h].country] += 1;
+        if (m[g.h].numOppsByCountry[teams[g.a].country] > 2 ||
+            m[g.a].numOppsByCountry[teams[g.h].country] > 2) {
+            if (!suppress)
+                std::cout << "INVALID DRAW: > 2 country limit exceeded"
+                          << std::endl;
+            return false;
+        }
+
+        if (!verifyDrawHomeAway(m, g.h, g.a)) {
+            return false;
+        }
+    }
+
+    int oppsPerPot = numGamesPerTeam / numPots;
+    for (auto &[teamInd, teamVerifierObj] : m) {
+        // check for correct total num of opps
+        if (teamVerifierObj.oppTeamInds.size() !=
+            static_cast<size_t>(numGamesPerTeam)) {
+            if (!suppress)
+                std::cout << "INVALID DRAW: " << teams[teamInd].abbrev
+                          << " has been drawn against "
+                          << teamVerifierObj.oppTeamInds.size()
+                          << " opponents (expected " << numGamesPerTeam << ")."
+                          << std::endl;
+            return false;
+        }
+
+        // check for correct num of opps per pot
+        for (int i = 1; i <= numPots; i++) {
+            if (teamVerifierObj.numGamesByPot[i] != oppsPerPot) {
+                if (!suppress)
+                    std::cout << "INVALID DRAW: " << teams[teamInd].abbrev
+                              << " has been drawn against "
+                              << teamVerifierObj.numGamesByPot[i]
+                              << " clubs in Pot " << i + 1 << " (expected "
+                              << oppsPerPot << ")." << std::endl;
+                return false;
+            }
+        }
+    }
+
+    if (!suppress)
+        std::cout << "Draw has been verified and is valid." << std::endl;
+    return true;
+}
+
+template <typename Format>
+DrawEngine<Format>::DrawEngine(std::shared_ptr<const DrawScenario> sc,
+                               const std::vector<Game> &initialGames, bool s)
+    : Draw(std::move(sc), POTS, TEAMS_PER_POT, GAMES_PER_TEAM,
+           GAMES_PER_POT_PAIR, s) {
+    reset(initialGames);
+}
+
+template <typename Format>
+DrawEngine<Format>::DrawEngine(
+    const std::vector<Team> &t, const std::vector<Game> &initialGames,
+    const std::unordered_set<std::string> &bannedCountryMatchups, bool s)
+    : DrawEngine(createScenario(t, bannedCountryMatchups), initialGames, s) {}
+
+template <typename Format>
+DrawEngine<Format>::DrawEngine(std::string teamsPath,
+                               std::string initialGamesPath,
+                               std::string bannedCountryMatchupsPath, bool s)
+    : Draw(createScenario(readCSVTeams(teamsPath),
+                          bannedCountryMatchupsPath != ""
+                              ? readTXTCountries(bannedCountryMatchupsPath)
+                              : std::unordered_set<std::string>()),
+           POTS, TEAMS_PER_POT, GAMES_PER_TEAM, GAMES_PER_POT_PAIR, s) {
+    reset(initialGamesPath != "" ? readTXTGames(initialGamesPath, teams)
+                                 : std::vector<Game>());
+}
+
+template <typename Format>
+std::shared_ptr<const DrawScenario> DrawEngine<Format>::createScenario(
+    const std::vector<Team> &t,
     const std::unordered_set<std::string> &bannedCountryMatchups) {
-    for (size_t i = 0; i < teams.size(); i++) {
-        numTeamsByCountry[teams[i].country] += 1;
-        teamIndsByCountry[teams[i].country].push_back(i);
-    }
-    for (int potInd = 0; potInd < numPots; potInd++) {
-        needsHomeAgainstPot.push_back(std::unordered_set<int>());
-        needsAwayAgainstPot.push_back(std::unordered_set<int>());
-        for (int teamInd = 0; teamInd < numTeams; teamInd++) {
-            needsHomeAgainstPot[potInd].insert(teamInd);
-            needsAwayAgainstPot[potInd].insert(teamInd);
-            countryHomeNeeds[teams[teamInd].country + ":" +
-                             std::to_string(potInd + 1)] += 1;
-            countryAwayNeeds[teams[teamInd].country + ":" +
-                             std::to_string(potInd + 1)] += 1;
+    if (t.size() != static_cast<size_t>(TEAMS)) {
+        std::cerr << "Draw::createScenario() error: expected " << TEAMS
+                  << " teams but got " << t.size() << std::endl;
+        exit(1);
+    }
+    auto sc = std::make_shared<DrawScenario>();
+    sc->teams = t;
+    // intern countries so draw state can be indexed by country id
+    std::unordered_map<std::string, int> countryIds; // country -> country id
+    for (size_t i = 0; i < t.size(); i++) {
+        auto it = countryIds.find(t[i].country);
+        if (it == countryIds.end()) {
+            it = countryIds.emplace(t[i].country, sc->countries.size()).first;
+            sc->countries.push_back(t[i].country);
+            sc->numTeamsByCountry.push_back(0);
+            sc->teamIndsByCountry.push_back(std::vector<int>());
         }
+        sc->teamCountryIds.push_back(it->second);
+        sc->numTeamsByCountry[it->second] += 1;
+        sc->teamIndsByCountry[it->second].push_back(i);
     }
-    // create all possible matchups (home vs away status matters)
+    if (sc->countries.size() > static_cast<size_t>(MAX_COUNTRIES)) {
+        std::cerr << "Draw::createScenario() error: draw exceeds "
+                  << MAX_COUNTRIES << " countries" << std::endl;
+        exit(1);
+    }
+    sc->teamsByPot.assign(POTS, 0);
+    sc->teamsByCountry.assign(sc->countries.size(), 0);
+    for (int teamInd = 0; teamInd < TEAMS; teamInd++) {
+        int country = sc->teamCountryIds[teamInd];
+        sc->teamsByPot[t[teamInd].pot - 1] |= uint64_t{1} << teamInd;
+        sc->teamsByCountry[country] |= uint64_t{1} << teamInd;
+    }
+    DFSContext &state = sc->initialState;
+    uint64_t allTeams =
+        TEAMS == 64 ? ~uint64_t{0} : (uint64_t{1} << (TEAMS % 64)) - 1;
+    for (int potInd = 0; potInd < POTS; potInd++) {
+        state.needsHomeAgainstPot[potInd] = allTeams;
+        state.needsAwayAgainstPot[potInd] = allTeams;
+        for (int teamInd = 0; teamInd < TEAMS; teamInd++) {
+            state.countryHomeNeeds[sc->teamCountryIds[teamInd]][potInd] += 1;
+            state.countryAwayNeeds[sc->teamCountryIds[teamInd]][potInd] += 1;
+        }
+    }
+    // create all possible matchups (home vs away status matters) as legal opps
+    // per team; DFSContext legal masks then index the remaining games
     // games must be contested btwn two teams of diff countries, and countries
     // cannot be banned from playing each other
-    // max of numTeams * numGamesPerTeam
-    for (int i = 0; i < numTeams - 1; i++) {
-        for (int j = i + 1; j < numTeams; j++) {
-            if (teams[i].country == teams[j].country ||
-                bannedCountryMatchups.count(teams[i].country + ":" +
-                                            teams[j].country) ||
-                bannedCountryMatchups.count(teams[j].country + ":" +
-                                            teams[i].country)) {
+    sc->legalOppsByTeamInd.assign(TEAMS, 0);
+    for (int i = 0; i < TEAMS - 1; i++) {
+        for (int j = i + 1; j < TEAMS; j++) {
+            if (t[i].country == t[j].country ||
+                bannedCountryMatchups.count(t[i].country + ":" +
+                                            t[j].country) ||
+                bannedCountryMatchups.count(t[j].country + ":" +
+                                            t[i].country)) {
                 continue;
             }
-            allGames.push_back(Game(i, j));
-            allGames.push_back(Game(j, i));
+            sc->legalOppsByTeamInd[i] |= uint64_t{1} << j;
+            sc->legalOppsByTeamInd[j] |= uint64_t{1} << i;
+        }
+    }
+    // FNV-1a over everything that determines the draw's outcomes
+    uint64_t h = 0xcbf29ce484222325;
+    auto mix = [&h](uint64_t x) {
+        for (int b = 0; b < 64; b += 8) {
+            h = (h ^ ((x >> b) & 0xff)) * 0x100000001b3;
+        }
+    };
+    auto mixString = [&mix](const std::string &str) {
+        for (unsigned char c : str) {
+            mix(c);
         }
+        mix(str.size());
+    };
+    mix(POTS);
+    mix(TEAMS_PER_POT);
+    mix(GAMES_PER_TEAM);
+    mix(GAMES_PER_POT_PAIR);
+    for (int teamInd = 0; teamInd < TEAMS; teamInd++) {
+        mix(t[teamInd].pot);
+        mixString(t[teamInd].abbrev);
+        mixString(t[teamInd].country);
+        mix(sc->legalOppsByTeamInd[teamInd]);
     }
+    sc->hash = h;
+    return sc;
+}
+
+template <typename Format>
+void DrawEngine<Format>::reset(const std::vector<Game> &initialGames) {
+    state = scenario->initialState;
+    dfsRefreshLegalMasks(state);
+    gamesByTeamInd.clear();
+    drawnTeamInds.clear();
+    pickedGames.clear();
+    std::fill(pickCredits.begin(), pickCredits.end(), 0.0);
     // initialize draw state with initial games
     for (const Game &g : initialGames) {
         updateDrawState(g);
@@ -86,98 +344,24 @@ void Draw::initializeState(
         }
         gamesByTeamInd[g.h].push_back(g);
         gamesByTeamInd[g.a].push_back(g);
-        allGames.erase(std::remove_if(allGames.begin(), allGames.end(),
-                                      [this](const Game &aG) {
-                                          return !validRemainingGame(aG);
-                                      }),
-                       allGames.end());
     }
 }
 
-const std::vector<Game> Draw::getPickedGames() const {
-    return pickedGames;
-}
-
-bool Draw::validRemainingGame(const Game &g) const {
+template <typename Format>
+bool DrawEngine<Format>::dfsValidRemainingGame(
+    const Game &g, const DFSContext &context) const {
     // g is Game under consideration; return true if Game is valid (should be
     // kept), false if invalid (should be removed)
-    std::string homePot = std::to_string(teams[g.h].pot);
-    std::string awayPot = std::to_string(teams[g.a].pot);
-    if (pickedGamesTeamInds.count(std::to_string(g.h) + ":" +
-                                  std::to_string(g.a)) || // Game already picked
-        pickedGamesTeamInds.count(
-            std::to_string(g.a) + ":" +
-            std::to_string(g.h)) || // Game's reverse fixture already picked
-        get_or(numHomeGamesByTeamInd, g.h, 0) ==
-            numGamesPerTeam /
-                2 || // Game's home team already has enough home games
-        get_or(numAwayGamesByTeamInd, g.a, 0) ==
-            numGamesPerTeam /
-                2 || // Game's away team already has enough away games
-        get_or(isPickedByTeamIndOppPotLocation,
-               std::to_string(g.h) + ":" + awayPot + ":h",
-               false) || // Game's home team has already played away
-                         // team's pot (as home team)
-        get_or(isPickedByTeamIndOppPotLocation,
-               std::to_string(g.a) + ":" + homePot + ":a",
-               false) || // Game's away team has already played home
-                         // team's pot (as away team)
-        get_or(numGamesByTeamIndOppCountry,
-               std::to_string(g.h) + ":" + teams[g.a].country, 0) ==
-            2 || // Game's home team has faced max opps from away team's country
-        get_or(numGamesByTeamIndOppCountry,
-               std::to_string(g.a) + ":" + teams[g.h].country, 0) ==
-            2 // Game's away team has faced max opps from home team's country
-    ) {
-        return false;
-    }
-    return true;
+    return (context.legalAwayOppsByTeamInd[g.h] >> g.a) & 1;
 }
 
-bool Draw::dfsValidRemainingGame(const Game &g,
-                                 const DFSContext &context) const {
-    // g is Game under consideration; return true if Game is valid (should be
-    // kept), false if invalid (should be removed)
-    std::string homePot = std::to_string(teams[g.h].pot);
-    std::string awayPot = std::to_string(teams[g.a].pot);
-    if (teams[g.h].country ==
-            teams[g.a].country || // home and away team from same country
-        context.pickedGamesTeamInds.count(
-            std::to_string(g.h) + ":" +
-            std::to_string(g.a)) || // Game already picked
-        context.pickedGamesTeamInds.count(
-            std::to_string(g.a) + ":" +
-            std::to_string(g.h)) || // Game's reverse fixture already picked
-        get_or(context.numHomeGamesByTeamInd, g.h, 0) ==
-            numGamesPerTeam /
-                2 || // Game's home team already has enough home games
-        get_or(context.numAwayGamesByTeamInd, g.a, 0) ==
-            numGamesPerTeam /
-                2 || // Game's away team already has enough away games
-        get_or(context.isPickedByTeamIndOppPotLocation,
-               std::to_string(g.h) + ":" + awayPot + ":h",
-               false) || // Game's home team has already played
-                         // away team's pot (as home team)
-        get_or(context.isPickedByTeamIndOppPotLocation,
-               std::to_string(g.a) + ":" + homePot + ":a",
-               false) || // Game's away team has already played
-                         // home team's pot (as away team)
-        get_or(context.numGamesByTeamIndOppCountry,
-               std::to_string(g.h) + ":" + teams[g.a].country, 0) ==
-            2 || // Game's home team has faced max opps from away team's country
-        get_or(context.numGamesByTeamIndOppCountry,
-               std::to_string(g.a) + ":" + teams[g.h].country, 0) ==
-            2 // Game's away team has faced max opps from home team's country
-    ) {
-        return false;
-    }
-    return true;
-}
-
-bool Draw::draw() {
+template <typename Format>
+bool DrawEngine<Format>::draw() {
+    initializeFeasibilityCache();
+    initializePortfolioStats();
     try {
-        for (int pot = 1; pot <= numPots; pot++) {
-            for (int i = 0; i < numTeamsPerPot; i++) {
+        for (int pot = 1; pot <= POTS; pot++) {
+            for (int i = 0; i < TEAMS_PER_POT; i++) {
                 // choose a team in the current pot
                 // retrieve all existing games involving this team
                 // pick games until all team's games are picked
@@ -213,27 +397,23 @@ bool Draw::draw() {
                 }
 
                 while (gamesByTeamInd[pickedTeamIndex].size() <
-                       static_cast<size_t>(numGamesPerTeam)) {
-                    std::shuffle(allGames.begin(), allGames.end(),
+                       static_cast<size_t>(GAMES_PER_TEAM)) {
+                    std::vector<Game> remaining = remainingGames(state);
+                    std::shuffle(remaining.begin(), remaining.end(),
                                  randomEngine);
-                    Game g = pickGame();
+                    Game g = pickGame(remaining);
                     updateDrawState(g);
                     // std::cout << GRAY << teams[g.h].abbrev << "-"
                     //           << teams[g.a].abbrev << RESET << std::endl;
                     gamesByTeamInd[g.h].push_back(g);
                     gamesByTeamInd[g.a].push_back(g);
-                    allGames.erase(
-                        std::remove_if(allGames.begin(), allGames.end(),
-                                       [this](const Game &aG) {
-                                           return !validRemainingGame(aG);
-                                       }),
-                        allGames.end());
                     if (!suppress) {
                         if (g.h == pickedTeamIndex || g.a == pickedTeamIndex) {
                             std::cout << teams[g.h].abbrev << "-"
                                       << teams[g.a].abbrev << "\t"
                                       << teams[g.h].pot << "-" << teams[g.a].pot
-                                      << " " << allGames.size() << std::endl;
+                                      << " " << numRemainingGames(state)
+                                      << std::endl;
                         }
                     }
                 }
@@ -254,20 +434,31 @@ bool Draw::draw() {
     }
 }
 
-bool Draw::draw(BS::light_thread_pool &pool) {
+template <typename Format>
+bool DrawEngine<Format>::draw(Scheduler &scheduler) {
+    initializeFeasibilityCache();
+    initializePortfolioStats();
     try {
         while (pickedGames.size() <
-               static_cast<size_t>(numGamesPerTeam * numTeams / 2)) {
-            std::shuffle(allGames.begin(), allGames.end(), randomEngine);
-            Game g = pickGame(pool);
+               static_cast<size_t>(GAMES_PER_TEAM * TEAMS / 2)) {
+            // each pick's numbers are a pure function of (key, stream, pick
+            // index), independent of thread and scheduling
+            randomEngine.seed(randomKey, randomStream,
+                              static_cast<uint32_t>(pickedGames.size()));
+            std::vector<Game> remaining = remainingGames(state);
+            std::shuffle(remaining.begin(), remaining.end(), randomEngine);
+            std::vector<Game> feasible;
+            Game g = pickGame(remaining, scheduler,
+                              creditPicks ? &feasible : nullptr);
+            // g is the first feasible game of its pot pair in shuffled order,
+            // i.e. uniform over them (or, if they are unknown, feasible only
+            // holds g, which credits the sampled pick)
+            for (const Game &f : feasible) {
+                pickCredits[f.h * TEAMS + f.a] += 1.0 / feasible.size();
+            }
             updateDrawState(g);
             gamesByTeamInd[g.h].push_back(g);
             gamesByTeamInd[g.a].push_back(g);
-            allGames.erase(std::remove_if(allGames.begin(), allGames.end(),
-                                          [this](const Game &aG) {
-                                              return !validRemainingGame(aG);
-                                          }),
-                           allGames.end());
         }
         return true;
 
@@ -276,178 +467,299 @@ bool Draw::draw(BS::light_thread_pool &pool) {
     }
 }
 
-void Draw::updateDrawState(const Game &g, bool revert) {
-    std::string homePot = std::to_string(teams[g.h].pot);
-    std::string awayPot = std::to_string(teams[g.a].pot);
-    if (revert) {
-        numGamesByPotPair[homePot + ":" + awayPot] -= 1;
-        numHomeGamesByTeamInd[g.h] -= 1;
-        numAwayGamesByTeamInd[g.a] -= 1;
-        numGamesByTeamIndOppCountry[std::to_string(g.h) + ":" +
-                                    teams[g.a].country] -= 1;
-        numGamesByTeamIndOppCountry[std::to_string(g.a) + ":" +
-                                    teams[g.h].country] -= 1;
-        isPickedByTeamIndOppPotLocation[std::to_string(g.h) + ":" + awayPot +
-                                        ":h"] = false;
-        isPickedByTeamIndOppPotLocation[std::to_string(g.a) + ":" + homePot +
-                                        ":a"] = false;
-        pickedGamesTeamInds.erase(std::to_string(g.h) + ":" +
-                                  std::to_string(g.a));
-        pickedGames.erase(
-            std::remove(pickedGames.begin(), pickedGames.end(), g),
-            pickedGames.end());
-        needsHomeAgainstPot[teams[g.a].pot - 1].insert(g.h);
-        needsAwayAgainstPot[teams[g.h].pot - 1].insert(g.a);
-        countryHomeNeeds[teams[g.h].country + ":" + awayPot] += 1;
-        countryAwayNeeds[teams[g.a].country + ":" + homePot] += 1;
-    } else {
-        numGamesByPotPair[homePot + ":" + awayPot] += 1;
-        numHomeGamesByTeamInd[g.h] += 1;
-        numAwayGamesByTeamInd[g.a] += 1;
-        numGamesByTeamIndOppCountry[std::to_string(g.h) + ":" +
-                                    teams[g.a].country] += 1;
-        numGamesByTeamIndOppCountry[std::to_string(g.a) + ":" +
-                                    teams[g.h].country] += 1;
-        isPickedByTeamIndOppPotLocation[std::to_string(g.h) + ":" + awayPot +
-                                        ":h"] = true;
-        isPickedByTeamIndOppPotLocation[std::to_string(g.a) + ":" + homePot +
-                                        ":a"] = true;
-        pickedGamesTeamInds.insert(std::to_string(g.h) + ":" +
-                                   std::to_string(g.a));
-        pickedGames.push_back(g);
-        needsHomeAgainstPot[teams[g.a].pot - 1].erase(g.h);
-        needsAwayAgainstPot[teams[g.h].pot - 1].erase(g.a);
-        countryHomeNeeds[teams[g.h].country + ":" + awayPot] -= 1;
-        countryAwayNeeds[teams[g.a].country + ":" + homePot] -= 1;
-    }
+template <typename Format>
+void DrawEngine<Format>::updateDrawState(const Game &g) {
+    // picks on obj state are never reverted, so trail is discarded
+    DFSTrail trail;
+    dfsUpdateDrawState(g, state, trail);
+    pickedGames.push_back(g);
 }
 
-void Draw::dfsUpdateDrawState(const Game &g, DFSContext &context,
-                              bool revert) const {
-    std::string homePot = std::to_string(teams[g.h].pot);
-    std::string awayPot = std::to_string(teams[g.a].pot);
-    if (revert) {
-        context.numGamesByPotPair[homePot + ":" + awayPot] -= 1;
-        context.numHomeGamesByTeamInd[g.h] -= 1;
-        context.numAwayGamesByTeamInd[g.a] -= 1;
-        context.numGamesByTeamIndOppCountry[std::to_string(g.h) + ":" +
-                                            teams[g.a].country] -= 1;
-        context.numGamesByTeamIndOppCountry[std::to_string(g.a) + ":" +
-                                            teams[g.h].country] -= 1;
-        context.isPickedByTeamIndOppPotLocation[std::to_string(g.h) + ":" +
-                                                awayPot + ":h"] = false;
-        context.isPickedByTeamIndOppPotLocation[std::to_string(g.a) + ":" +
-                                                homePot + ":a"] = false;
-        context.pickedGamesTeamInds.erase(std::to_string(g.h) + ":" +
-                                          std::to_string(g.a));
-        context.pickedGames.erase(std::remove(context.pickedGames.begin(),
-                                              context.pickedGames.end(), g),
-                                  context.pickedGames.end());
-        context.needsHomeAgainstPot[teams[g.a].pot - 1].insert(g.h);
-        context.needsAwayAgainstPot[teams[g.h].pot - 1].insert(g.a);
-        context.countryHomeNeeds[teams[g.h].country + ":" + awayPot] += 1;
-        context.countryAwayNeeds[teams[g.a].country + ":" + homePot] += 1;
-    } else {
-        context.numGamesByPotPair[homePot + ":" + awayPot] += 1;
-        context.numHomeGamesByTeamInd[g.h] += 1;
-        context.numAwayGamesByTeamInd[g.a] += 1;
-        context.numGamesByTeamIndOppCountry[std::to_string(g.h) + ":" +
-                                            teams[g.a].country] += 1;
-        context.numGamesByTeamIndOppCountry[std::to_string(g.a) + ":" +
-                                            teams[g.h].country] += 1;
-        context.isPickedByTeamIndOppPotLocation[std::to_string(g.h) + ":" +
-                                                awayPot + ":h"] = true;
-        context.isPickedByTeamIndOppPotLocation[std::to_string(g.a) + ":" +
-                                                homePot + ":a"] = true;
-        context.pickedGamesTeamInds.insert(std::to_string(g.h) + ":" +
-                                           std::to_string(g.a));
-        context.pickedGames.push_back(g);
-        context.needsHomeAgainstPot[teams[g.a].pot - 1].erase(g.h);
-        context.needsAwayAgainstPot[teams[g.h].pot - 1].erase(g.a);
-        context.countryHomeNeeds[teams[g.h].country + ":" + awayPot] -= 1;
-        context.countryAwayNeeds[teams[g.a].country + ":" + homePot] -= 1;
+template <typename Format>
+void DrawEngine<Format>::dfsUpdateDrawState(const Game &g, DFSContext &context,
+                                            DFSTrail &trail) const {
+    // pick g, recording every write on trail (dfs unwinds it to revert g)
+    int homePot = teams[g.h].pot - 1;
+    int awayPot = teams[g.a].pot - 1;
+    int homeCountry = teamCountryIds[g.h];
+    int awayCountry = teamCountryIds[g.a];
+    trail.set(context.numGamesByPotPair[homePot][awayPot],
+              context.numGamesByPotPair[homePot][awayPot] + 1);
+    trail.set(context.numHomeGamesByTeamInd[g.h],
+              context.numHomeGamesByTeamInd[g.h] + 1);
+    trail.set(context.numAwayGamesByTeamInd[g.a],
+              context.numAwayGamesByTeamInd[g.a] + 1);
+    trail.set(context.oppPotsByTeamIndLocation[g.h][HOME],
+              static_cast<uint8_t>(
+                  context.oppPotsByTeamIndLocation[g.h][HOME] |
+                  (1 << awayPot)));
+    trail.set(context.oppPotsByTeamIndLocation[g.a][AWAY],
+              static_cast<uint8_t>(
+                  context.oppPotsByTeamIndLocation[g.a][AWAY] |
+                  (1 << homePot)));
+    trail.set(context.oppsByTeamInd[g.h],
+              context.oppsByTeamInd[g.h] | (uint64_t{1} << g.a));
+    trail.set(context.oppsByTeamInd[g.a],
+              context.oppsByTeamInd[g.a] | (uint64_t{1} << g.h));
+    trail.set(context.numPickedGames, context.numPickedGames + 1);
+    trail.set(context.hash, context.hash ^ gameHash(g));
+    // needs are shared by pots in the same group (pot pairing for UECL)
+    for (uint8_t pots = PotPolicy::potGroup(awayPot); pots; pots &= pots - 1) {
+        int pot = __builtin_ctz(pots);
+        trail.set(context.needsHomeAgainstPot[pot],
+                  context.needsHomeAgainstPot[pot] & ~(uint64_t{1} << g.h));
+        trail.set(context.countryHomeNeeds[homeCountry][pot],
+                  context.countryHomeNeeds[homeCountry][pot] - 1);
+    }
+    for (uint8_t pots = PotPolicy::potGroup(homePot); pots; pots &= pots - 1) {
+        int pot = __builtin_ctz(pots);
+        trail.set(context.needsAwayAgainstPot[pot],
+                  context.needsAwayAgainstPot[pot] & ~(uint64_t{1} << g.a));
+        trail.set(context.countryAwayNeeds[awayCountry][pot],
+                  context.countryAwayNeeds[awayCountry][pot] - 1);
     }
+    dfsUpdateLegalMasks(g, context, trail);
 }
 
-void Draw::dfsSortRemainingGames(std::vector<Game> &remainingGames,
-                                 const DFSContext &context,
-                                 int sortMode) const {
-    // stable sort remaining games based on sortMode
-
-    // used within DFS to find solution faster, using multiple threads if
-    // necessary
-
-    // sortMode==0:
-    // - sort by away team whose country has most teams, then by away team
-    //   with most remaining unscheduled games
-    // sortMode==1:
-    // - sort by away team whose country has least teams, then by away team with
-    //   most remaining unscheduled games
-    // sortMode==2:
-    // - sort by away team with most remaining unscheduled games
-    std::stable_sort(
-        remainingGames.begin(), remainingGames.end(),
-        [this, sortMode, &context](const Game &g1, const Game &g2) {
-            int countryTeams1 = numTeamsByCountry.at(teams[g1.a].country);
-            int countryTeams2 = numTeamsByCountry.at(teams[g2.a].country);
-            if (sortMode != 2 && countryTeams1 != countryTeams2) {
-                if (sortMode == 0) {
-                    return countryTeams1 > countryTeams2;
-                } else {
-                    return countryTeams1 < countryTeams2;
-                }
+template <typename Format>
+void DrawEngine<Format>::dfsUpdateLegalMasks(const Game &g,
+                                             DFSContext &context,
+                                             DFSTrail &trail) const {
+    // update legality kernel inputs touched by picking g, then recompute the
+    // legal opps of g's teams
+
+    // teams with all home/away games picked
+    if (context.numHomeGamesByTeamInd[g.h] == GAMES_PER_TEAM / 2) {
+        trail.set(context.homeCompleteTeams,
+                  context.homeCompleteTeams | (uint64_t{1} << g.h));
+    }
+    if (context.numAwayGamesByTeamInd[g.a] == GAMES_PER_TEAM / 2) {
+        trail.set(context.awayCompleteTeams,
+                  context.awayCompleteTeams | (uint64_t{1} << g.a));
+    }
+
+    // pots each team can no longer face at each location
+    for (int t : {g.h, g.a}) {
+        uint64_t teamBit = uint64_t{1} << t;
+        for (int location : {HOME, AWAY}) {
+            uint8_t blockedPots = PotPolicy::blockedPots(
+                context.oppPotsByTeamIndLocation[t][location],
+                context.oppPotsByTeamIndLocation[t][location == HOME ? AWAY
+                                                                     : HOME]);
+            trail.set(context.blockedPotsByTeamIndLocation[t][location],
+                      blockedPots);
+            for (uint8_t pots = blockedPots; pots; pots &= pots - 1) {
+                int pot = __builtin_ctz(pots);
+                trail.set(context.blockedTeamsByPotLocation[pot][location],
+                          context.blockedTeamsByPotLocation[pot][location] |
+                              teamBit);
             }
-            int remainingGames1 =
-                numGamesPerTeam -
-                get_or(context.numHomeGamesByTeamInd, g1.a, 0) -
-                get_or(context.numAwayGamesByTeamInd, g1.a, 0);
-            int remainingGames2 =
-                numGamesPerTeam -
-                get_or(context.numHomeGamesByTeamInd, g2.a, 0) -
-                get_or(context.numAwayGamesByTeamInd, g2.a, 0);
-            return remainingGames1 > remainingGames2;
-        });
+        }
+    }
+
+    // countries each team has faced once, then twice
+    for (const Game &side : {g, Game(g.a, g.h)}) {
+        int oppCountry = teamCountryIds[side.a];
+        uint64_t countryBit = uint64_t{1} << oppCountry;
+        if (!(context.facedCountriesByTeamInd[side.h] & countryBit)) {
+            trail.set(context.facedCountriesByTeamInd[side.h],
+                      context.facedCountriesByTeamInd[side.h] | countryBit);
+        } else {
+            trail.set(context.maxedOppsByTeamInd[side.h],
+                      context.maxedOppsByTeamInd[side.h] |
+                          teamsByCountry[oppCountry]);
+            trail.set(context.maxedTeamsByCountry[oppCountry],
+                      context.maxedTeamsByCountry[oppCountry] |
+                          (uint64_t{1} << side.h));
+        }
+    }
+
+    // legality of a pair only depends on the state of its 2 teams, so only
+    // g.h's and g.a's rows and columns can change
+    dfsRefreshLegalMasks(g.h, context, trail);
+    dfsRefreshLegalMasks(g.a, context, trail);
+}
 
-    // (slower) alternative:
-    // sortMode==0:
-    // - sort by away team with least countryAwayNeeds, then by away team with
-    //   least remaining unscheduled games
-    // sortMode==1:
-    // - sort by away team with most countryAwayNeeds, then by away team with
-    //   least remaining unscheduled games
-    // sortMode==2:
-    // - sort by away team with least remaining unscheduled games
-    // std::stable_sort(
-    //     remainingGames.begin(), remainingGames.end(),
-    //     [this, sortMode, &context](const Game &g1, const Game &g2) {
-    //         int awayNeeds1 = context.countryAwayNeeds.at(
-    //             teams[g1.a].country + ":" + std::to_string(teams[g1.h].pot));
-    //         int awayNeeds2 = context.countryAwayNeeds.at(
-    //             teams[g2.a].country + ":" + std::to_string(teams[g2.h].pot));
-    //         if (sortMode != 2 && awayNeeds1 != awayNeeds2) {
-    //             if (sortMode == 0) {
-    //                 return awayNeeds1 < awayNeeds2;
-    //             } else {
-    //                 return awayNeeds1 > awayNeeds2;
-    //             }
-    //         }
-    //         int remainingGames1 =
-    //             numGamesPerTeam -
-    //             get_or(context.numHomeGamesByTeam, g1.a, 0) -
-    //             get_or(context.numAwayGamesByTeam, g1.a, 0);
-    //         int remainingGames2 =
-    //             numGamesPerTeam -
-    //             get_or(context.numHomeGamesByTeam, g2.a, 0) -
-    //             get_or(context.numAwayGamesByTeam, g2.a, 0);
-    //         return remainingGames1 < remainingGames2;
-    //     });
+template <typename Format>
+void DrawEngine<Format>::dfsRefreshLegalMasks(DFSContext &context) const {
+    for (int t = 0; t < TEAMS; t++) {
+        context.legalAwayOppsByTeamInd[t] = dfsLegalOpps(t, HOME, context);
+        context.legalHomeOppsByTeamInd[t] = dfsLegalOpps(t, AWAY, context);
+    }
+}
+
+template <typename Format>
+void DrawEngine<Format>::dfsRefreshLegalMasks(int teamIndex,
+                                              DFSContext &context,
+                                              DFSTrail &trail) const {
+    // recompute team's legal opps, then mirror changed bits into its opps'
+    // legal opps (team h can host team a iff bit a of
+    // legalAwayOppsByTeamInd[h] is set iff bit h of legalHomeOppsByTeamInd[a]
+    // is set)
+    uint64_t teamBit = uint64_t{1} << teamIndex;
+    uint64_t awayOpps = dfsLegalOpps(teamIndex, HOME, context);
+    uint64_t homeOpps = dfsLegalOpps(teamIndex, AWAY, context);
+    for (uint64_t changed =
+             awayOpps ^ context.legalAwayOppsByTeamInd[teamIndex];
+         changed; changed &= changed - 1) {
+        uint64_t &oppMask =
+            context.legalHomeOppsByTeamInd[__builtin_ctzll(changed)];
+        trail.set(oppMask, oppMask ^ teamBit);
+    }
+    for (uint64_t changed =
+             homeOpps ^ context.legalHomeOppsByTeamInd[teamIndex];
+         changed; changed &= changed - 1) {
+        uint64_t &oppMask =
+            context.legalAwayOppsByTeamInd[__builtin_ctzll(changed)];
+        trail.set(oppMask, oppMask ^ teamBit);
+    }
+    trail.set(context.legalAwayOppsByTeamInd[teamIndex], awayOpps);
+    trail.set(context.legalHomeOppsByTeamInd[teamIndex], homeOpps);
+}
+
+template <typename Format>
+uint64_t DrawEngine<Format>::dfsLegalOpps(int teamIndex, int location,
+                                          const DFSContext &context) const {
+    // opps team can still face at location (HOME -> teams it can host, AWAY
+    // -> teams it can visit)
+    int oppLocation = location == HOME ? AWAY : HOME;
+    uint64_t completeTeams = location == HOME ? context.homeCompleteTeams
+                                              : context.awayCompleteTeams;
+    uint64_t oppCompleteTeams = location == HOME ? context.awayCompleteTeams
+                                                 : context.homeCompleteTeams;
+    if ((completeTeams >> teamIndex) & 1) {
+        return 0;
+    }
+    return legalOppsByTeamInd[teamIndex] & ~context.oppsByTeamInd[teamIndex] &
+           ~context.maxedOppsByTeamInd[teamIndex] &
+           ~context.maxedTeamsByCountry[teamCountryIds[teamIndex]] &
+           ~oppCompleteTeams &
+           ~teamsInPots(
+               context.blockedPotsByTeamIndLocation[teamIndex][location]) &
+           ~context.blockedTeamsByPotLocation[teams[teamIndex].pot - 1]
+                                            [oppLocation];
+}
+
+template <typename Format>
+std::vector<Game>
+DrawEngine<Format>::remainingGames(const DFSContext &context) const {
+    // remaining potential Games, ordered by home team ind, then away team ind
+    std::vector<Game> games;
+    for (int h = 0; h < TEAMS; h++) {
+        for (uint64_t awayTeams = context.legalAwayOppsByTeamInd[h]; awayTeams;
+             awayTeams &= awayTeams - 1) {
+            games.push_back(Game(h, __builtin_ctzll(awayTeams)));
+        }
+    }
+    return games;
+}
+
+template <typename Format>
+int DrawEngine<Format>::numRemainingGames(const DFSContext &context) const {
+    int count = 0;
+    for (int h = 0; h < TEAMS; h++) {
+        count += __builtin_popcountll(context.legalAwayOppsByTeamInd[h]);
+    }
+    return count;
+}
+
+template <typename Format>
+uint64_t DrawEngine<Format>::teamsInPots(uint8_t pots) const {
+    uint64_t teamsMask = 0;
+    for (int pot = 0; pot < POTS; pot++) {
+        if ((pots >> pot) & 1) {
+            teamsMask |= teamsByPot[pot];
+        }
+    }
+    return teamsMask;
+}
+
+template <typename Format>
+void DrawEngine<Format>::dfsSortRemainingGames(Game *first, Game *last,
+                                               const DFSContext &context,
+                                               int ordering,
+                                               uint64_t salt) const {
+    // stable sort a frame's candidate games (same home team) by ordering (see
+    // DFSOrdering), to find a solution faster; if salt is nonzero, games
+    // the ordering ties are ordered by a hash of state and salt instead of
+    // kept in place
+    // - insertion sort: ranges are at most TEAMS_PER_POT long, and unlike
+    //   std::stable_sort it never allocates a temporary buffer
+    int homePot = first != last ? teams[first->h].pot - 1 : 0;
+    auto gamesLeft = [&context](int teamIndex) {
+        return GAMES_PER_TEAM - context.numHomeGamesByTeamInd[teamIndex] -
+               context.numAwayGamesByTeamInd[teamIndex];
+    };
+    if (ordering == RANDOM_TIES && !salt) {
+        salt = 1;
+    }
+    auto before = [this, ordering, salt, homePot, &context,
+                   &gamesLeft](const Game &g1, const Game &g2) {
+        int country1 = teamCountryIds[g1.a];
+        int country2 = teamCountryIds[g2.a];
+        int left1 = gamesLeft(g1.a);
+        int left2 = gamesLeft(g2.a);
+        bool mostLeftFirst = true;
+        switch (ordering) {
+        case BIG_COUNTRY_FIRST:
+        case RANDOM_TIES:
+        case SMALL_COUNTRY_FIRST: {
+            int countryTeams1 = numTeamsByCountry[country1];
+            int countryTeams2 = numTeamsByCountry[country2];
+            if (countryTeams1 != countryTeams2) {
+                return (ordering == SMALL_COUNTRY_FIRST) ==
+                       (countryTeams1 < countryTeams2);
+            }
+            break;
+        }
+        case LOW_COUNTRY_NEEDS_FIRST:
+        case HIGH_COUNTRY_NEEDS_FIRST: {
+            int needs1 = context.countryAwayNeeds[country1][homePot];
+            int needs2 = context.countryAwayNeeds[country2][homePot];
+            if (needs1 != needs2) {
+                return (ordering == LOW_COUNTRY_NEEDS_FIRST) ==
+                       (needs1 < needs2);
+            }
+            mostLeftFirst = false;
+            break;
+        }
+        case FEWEST_GAMES_LEFT_FIRST:
+            mostLeftFirst = false;
+            break;
+        case FEWEST_OPTIONS_FIRST: {
+            int options1 = __builtin_popcountll(
+                context.legalHomeOppsByTeamInd[g1.a] & teamsByPot[homePot]);
+            int options2 = __builtin_popcountll(
+                context.legalHomeOppsByTeamInd[g2.a] & teamsByPot[homePot]);
+            if (options1 != options2) {
+                return options1 < options2;
+            }
+            break;
+        }
+        }
+        if (left1 != left2) {
+            return mostLeftFirst == (left1 > left2);
+        }
+        // varies with state and salt, but is reproducible
+        return salt && (gameHash(g1) ^ context.hash ^ salt) <
+                           (gameHash(g2) ^ context.hash ^ salt);
+    };
+    for (Game *it = first; it != last; it++) {
+        Game g = *it;
+        Game *hole = it;
+        for (; hole != first && before(g, *(hole - 1)); hole--) {
+            *hole = *(hole - 1);
+        }
+        *hole = g;
+    }
 }
 
-int Draw::pickTeamIndex(int pot) {
+template <typename Format>
+int DrawEngine<Format>::pickTeamIndex(int pot) {
     // auto-pick random team index out of remaining teams in current pot
-    std::vector<int> teamIndices(numTeamsPerPot);
+    std::vector<int> teamIndices(TEAMS_PER_POT);
     std::iota(teamIndices.begin(), teamIndices.end(),
-              (pot - 1) * numTeamsPerPot);
+              (pot - 1) * TEAMS_PER_POT);
     teamIndices.erase(std::remove_if(teamIndices.begin(), teamIndices.end(),
                                      [this](int teamIndex) {
                                          return drawnTeamInds.count(teamIndex);
@@ -459,141 +771,428 @@ int Draw::pickTeamIndex(int pot) {
     return pickedTeamIndex;
 }
 
-DFSContext Draw::createDFSContext() const {
-    DFSContext currentDrawState;
-    currentDrawState.pickedGames = pickedGames;
-    currentDrawState.numGamesByPotPair = numGamesByPotPair;
-    currentDrawState.numHomeGamesByTeamInd = numHomeGamesByTeamInd;
-    currentDrawState.numAwayGamesByTeamInd = numAwayGamesByTeamInd;
-    currentDrawState.numGamesByTeamIndOppCountry = numGamesByTeamIndOppCountry;
-    currentDrawState.isPickedByTeamIndOppPotLocation =
-        isPickedByTeamIndOppPotLocation;
-    currentDrawState.pickedGamesTeamInds = pickedGamesTeamInds;
-    currentDrawState.needsHomeAgainstPot = needsHomeAgainstPot;
-    currentDrawState.needsAwayAgainstPot = needsAwayAgainstPot;
-    currentDrawState.countryHomeNeeds = countryHomeNeeds;
-    currentDrawState.countryAwayNeeds = countryAwayNeeds;
-    return currentDrawState;
+template <typename Format>
+DFSContext DrawEngine<Format>::createDFSContext() const {
+    return state;
+}
+
+// per-thread DFS trails, reused across searches so that a warm worker performs
+// no heap allocations while searching; a search nested inside another (see
+// dfsPoll) gets the next trail
+static thread_local int dfsSearchDepth = 0;
+
+static DFSTrail &workerTrail() {
+    thread_local std::array<DFSTrail, DFSPortfolio::NUM_SLOTS> trails =
+        [] {
+            std::array<DFSTrail, DFSPortfolio::NUM_SLOTS> t;
+            for (DFSTrail &trail : t) {
+                trail.entries.reserve(1 << 14);
+            }
+            return t;
+        }();
+    DFSTrail &trail = trails[dfsSearchDepth];
+    trail.entries.clear();
+    return trail;
+}
+
+// per-thread slots for subtrees split off this worker's searches; a search
+// takes slots above those of the searches it is nested in, and releases them
+// once its subtrees have returned
+constexpr int MAX_SPLIT_SUBTREES = 32;
+
+struct SubtreePool {
+    std::vector<DFSSubtree> slots;
+    int top = 0; // # slots in use
+};
+
+static SubtreePool &workerSubtrees() {
+    thread_local SubtreePool pool = [] {
+        SubtreePool p;
+        p.slots.resize(MAX_SPLIT_SUBTREES);
+        return p;
+    }();
+    return pool;
+}
+
+template <typename Format>
+void DrawEngine<Format>::dfsSearch(DFSPortfolio &portfolio,
+                                   int slot) const {
+    // run one of portfolio's DFS searches from obj state on the calling
+    // worker; the first search to finish reports the portfolio's result
+    DFSSearch search{createDFSContext(),
+                     workerTrail(),
+                     slot,
+                     portfolio.orderings[slot],
+                     portfolio,
+                     dfsSearchDepth ? portfolio.budget.nestedNodes
+                                    : portfolio.budget.expandNodes};
+    bool result = dfsRun(portfolio.game, search);
+    // a rejection only holds if no subtree split off the search gave up
+    bool expected = false;
+    if (!search.exhausted &&
+        (result || !portfolio.groups[slot].exhausted.load(
+                       std::memory_order_relaxed)) &&
+        portfolio.stop.compare_exchange_strong(expected, true)) {
+        portfolio.winner = slot;
+        portfolio.answerNodes = search.numNodes;
+        portfolio.result.store(result, std::memory_order_relaxed);
+    }
+}
+
+template <typename Format>
+void DrawEngine<Format>::runPortfolioSearch(void *arg) {
+    // Scheduler::Task entry point for portfolio searches spawned by dfsPoll
+    DFSPortfolio::Search &s = *static_cast<DFSPortfolio::Search *>(arg);
+    static_cast<const DrawEngine *>(s.portfolio->engine)
+        ->dfsSearch(*s.portfolio, s.slot);
+    s.portfolio->numSpawned.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+template <typename Format>
+void DrawEngine<Format>::dfsSubtreeSearch(DFSSubtree &subtree) const {
+    // search subtree on the calling worker, from a context rebuilt by
+    // replaying its path; only an acceptance decides the portfolio's result,
+    // since the rest of the tree is searched elsewhere
+    DFSPortfolio &portfolio = *subtree.portfolio;
+    DFSSearch search{createDFSContext(),
+                     workerTrail(),
+                     subtree.slot,
+                     portfolio.orderings[subtree.slot],
+                     portfolio,
+                     portfolio.budget.nestedNodes};
+    search.basePath = subtree.path.data();
+    search.basePathLength = subtree.pathLength - 1;
+    for (int i = 0; i < search.basePathLength; i++) {
+        dfsUpdateDrawState(subtree.path[i], search.context, search.trail);
+    }
+    search.trail.entries.clear(); // path is never reverted
+    bool result = dfsRun(subtree.path[subtree.pathLength - 1], search);
+    bool expected = false;
+    if (search.exhausted) {
+        portfolio.groups[subtree.slot].exhausted.store(
+            true, std::memory_order_relaxed);
+    } else if (result &&
+               portfolio.stop.compare_exchange_strong(expected, true)) {
+        portfolio.winner = subtree.slot;
+        portfolio.answerNodes = search.numNodes;
+        portfolio.result.store(1, std::memory_order_relaxed);
+    }
+}
+
+template <typename Format>
+void DrawEngine<Format>::runSubtreeSearch(void *arg) {
+    // Scheduler::Task entry point for subtrees split off by dfsSplit
+    DFSSubtree &subtree = *static_cast<DFSSubtree *>(arg);
+    DFSSearch *donor = subtree.donor;
+    static_cast<const DrawEngine *>(subtree.portfolio->engine)
+        ->dfsSubtreeSearch(subtree);
+    donor->numSplit.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+template <typename Format>
+bool DrawEngine<Format>::dfsRun(const Game &g, DFSSearch &search) const {
+    // run search from g on the calling worker, then wait out the subtrees
+    // split off it (running any that weren't stolen)
+    SubtreePool &pool = workerSubtrees();
+    int poolTop = pool.top;
+    dfsSearchDepth++;
+    uint64_t allocations = threadAllocations();
+    bool result = dfs(g, search);
+    recordDFSAllocations(threadAllocations() - allocations);
+    dfsSearchDepth--;
+    if (search.portfolio.scheduler) {
+        search.portfolio.scheduler->helpWhile([&search]() {
+            return search.numSplit.load(std::memory_order_acquire) > 0;
+        });
+    }
+    pool.top = poolTop;
+    return result;
+}
+
+template <typename Format>
+void DrawEngine<Format>::dfsPoll(DFSSearch &search) const {
+    // called every DFS_POLL_NODES nodes: enforce node budgets (and wall-clock
+    // safety net), and once search has used its slice, start sibling searches
+    // with other orderings and split off subtrees for idle workers
+    DFSPortfolio &portfolio = search.portfolio;
+    // node budget is shared with the searches split off the same tree
+    if (portfolio.groups[search.slot].numNodes.fetch_add(
+            DFS_POLL_NODES, std::memory_order_relaxed) +
+            DFS_POLL_NODES >=
+        portfolio.budget.timeoutNodes) {
+        search.exhausted = true;
+        return;
+    }
+    if (std::chrono::steady_clock::now() >= portfolio.deadline) {
+        portfolio.stop.store(true, std::memory_order_relaxed);
+        return;
+    }
+    if (search.numNodes < search.sliceNodes) {
+        return;
+    }
+    if (!portfolio.expanded.exchange(true, std::memory_order_relaxed) &&
+        portfolio.scheduler) {
+        for (int slot = 1; slot < DFSPortfolio::NUM_SLOTS; slot++) {
+            portfolio.numSpawned.fetch_add(1, std::memory_order_relaxed);
+            if (!portfolio.scheduler->spawn(
+                    {&DrawEngine::runPortfolioSearch,
+                     &portfolio.searches[slot]})) {
+                portfolio.numSpawned.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    // siblings no idle worker has stolen run nested on this worker (each for
+    // nestedNodes before nesting the next), so a search stuck on a bad sort
+    // order can't starve the others even with every worker busy
+    if (portfolio.scheduler && dfsSearchDepth < DFSPortfolio::NUM_SLOTS) {
+        portfolio.scheduler->helpOnce();
+    }
+    // after helping, so a subtree split off now is left for idle workers
+    if (portfolio.scheduler && portfolio.scheduler->numIdleWorkers() > 0) {
+        dfsSplit(search);
+    }
+}
+
+template <typename Format>
+void DrawEngine<Format>::dfsSplit(DFSSearch &search) const {
+    // spawn the last untried candidate of search's shallowest frame (the
+    // largest subtree left) as a task for idle workers to steal
+    SubtreePool &pool = workerSubtrees();
+    if (pool.top == MAX_SPLIT_SUBTREES) {
+        return;
+    }
+    int depth = 0;
+    while (depth < search.numFrames &&
+           search.frames[depth]->end - search.frames[depth]->next <= 1) {
+        depth++;
+    }
+    if (depth == search.numFrames) {
+        return;
+    }
+    DFSFrame &frame = *search.frames[depth];
+    DFSSubtree &subtree = pool.slots[pool.top];
+    subtree.portfolio = &search.portfolio;
+    subtree.donor = &search;
+    subtree.slot = search.slot;
+    int n = 0;
+    for (int i = 0; i < search.basePathLength; i++) {
+        subtree.path[n++] = search.basePath[i];
+    }
+    for (int i = 0; i <= depth; i++) {
+        subtree.path[n++] = search.frames[i]->game;
+    }
+    subtree.path[n++] = frame.candidates[frame.end - 1];
+    subtree.pathLength = n;
+    search.numSplit.fetch_add(1, std::memory_order_relaxed);
+    if (!search.portfolio.scheduler->spawn(
+            {&DrawEngine::runSubtreeSearch, &subtree})) {
+        search.numSplit.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+    pool.top++;
+    frame.end--;
+    // frame and its ancestors no longer search their whole subtrees
+    for (int i = 0; i <= depth; i++) {
+        search.frames[i]->split = true;
+    }
 }
 
-Game Draw::pickGame(BS::light_thread_pool &pool) const {
+template <typename Format>
+void DrawEngine<Format>::dfsRecordWitness(const Game &g,
+                                          const DFSSearch &search) const {
+    // g was just accepted, so the path to it (from obj state) is part of a
+    // completed draw, and each of its games is a feasible next pick; only the
+    // portfolio's first accepted path is recorded
+    DFSPortfolio &portfolio = search.portfolio;
+    if (!portfolio.witness ||
+        portfolio.witnessRecorded.exchange(true, std::memory_order_relaxed)) {
+        return;
+    }
+    for (int i = 0; i < search.basePathLength; i++) {
+        portfolio.witness->push_back(search.basePath[i]);
+    }
+    for (int i = 0; i < search.numFrames; i++) {
+        portfolio.witness->push_back(search.frames[i]->game);
+    }
+    portfolio.witness->push_back(g);
+}
+
+template <typename Format>
+Game DrawEngine<Format>::pickGame(const std::vector<Game> &remainingGames,
+                                  Scheduler &scheduler,
+                                  std::vector<Game> *feasibleGames) const {
     // used in simulations to pick next game
-    // use separate thread pools for outer simulations and inner DFS
+    // inner DFS searches share the scheduler running outer simulations
 
-    std::vector<Game> orderedRemainingGames(allGames);
+    std::vector<Game> orderedRemainingGames(remainingGames);
 
     // sort remaining games by home pot, then away pot
+    auto potPairLess = [this](const Game &g1, const Game &g2) {
+        if (teams[g1.h].pot < teams[g2.h].pot)
+            return true;
+        if (teams[g2.h].pot < teams[g1.h].pot)
+            return false;
+        return teams[g1.a].pot < teams[g2.a].pot;
+    };
     std::stable_sort(orderedRemainingGames.begin(), orderedRemainingGames.end(),
-                     [this](const Game &g1, const Game &g2) {
-                         if (teams[g1.h].pot < teams[g2.h].pot)
-                             return true;
-                         if (teams[g2.h].pot < teams[g1.h].pot)
-                             return false;
-                         return teams[g1.a].pot < teams[g2.a].pot;
-                     });
-
-    for (const Game &g : orderedRemainingGames) {
-        // perform "weak" checking first (each team needing away/home game
-        // against g.h/g.a pot must have >= 1 valid matchup left), which should
-        // be ok >80% of the time; if this leads to timeout, repeat with
-        // "strong" checking (global country checks)
+                     potPairLess);
+
+    // perform "weak" checking first (each team needing away/home game against
+    // g.h/g.a pot must have >= 1 valid matchup left), which should be ok >80%
+    // of the time; if this leads to timeout, repeat with "strong" checking
+    // (per pot group flow networks with country caps)
+    auto isFeasible = [this, &scheduler](const Game &g,
+                                         std::vector<Game> *witness) {
         try {
-            if (testCandidateGame(g, pool, false)) {
-                return g;
-            }
+            return testCandidateGame(g, scheduler, false, witness);
         } catch (const TimeoutException &e) {
-            if (testCandidateGame(g, pool, true)) {
-                return g;
+            return testCandidateGame(g, scheduler, true, witness);
+        }
+    };
+
+    // games of accepted test paths, known feasible without a test of their
+    // own (see dfsRecordWitness)
+    std::vector<Game> witness;
+    std::vector<Game> *witnessPtr = feasibleGames ? &witness : nullptr;
+
+    for (auto it = orderedRemainingGames.begin();
+         it != orderedRemainingGames.end(); ++it) {
+        if (!isFeasible(*it, witnessPtr)) {
+            continue;
+        }
+        if (feasibleGames) {
+            // test the games of the same pot pair not tested yet; if one
+            // times out, the pot pair's feasible games are unknown, so only
+            // the pick is reported
+            feasibleGames->assign(1, *it);
+            std::array<uint64_t, TEAMS> knownAwayTeams{};
+            auto classEnd =
+                std::upper_bound(it, orderedRemainingGames.end(), *it,
+                                 potPairLess);
+            for (auto other = it + 1; other != classEnd; ++other) {
+                for (const Game &w : witness) {
+                    knownAwayTeams[w.h] |= uint64_t{1} << w.a;
+                }
+                witness.clear();
+                bool feasible = (knownAwayTeams[other->h] >> other->a) & 1;
+                if (!feasible) {
+                    try {
+                        feasible = isFeasible(*other, &witness);
+                    } catch (const TimeoutException &e) {
+                        feasibleGames->assign(1, *it);
+                        return *it;
+                    }
+                }
+                if (feasible) {
+                    feasibleGames->push_back(*other);
+                }
             }
         }
+        return *it;
     }
 
     std::cerr << "Draw::pickGame() error: no game picked" << std::endl;
     exit(2);
 }
 
-bool Draw::testCandidateGame(const Game &g, BS::light_thread_pool &pool,
-                             bool strongCheck) const {
-    // g is candidate game
-    // return true if valid game, false if invalid, throw TimeoutException if
-    // timeout
-    std::atomic<bool> stop{false};
-    std::chrono::steady_clock::time_point deadline =
-        std::chrono::steady_clock::now() + std::chrono::milliseconds(2500);
-    std::promise<bool> resultPromise;
-    std::shared_future<bool> resultFuture = resultPromise.get_future().share();
-
-    // DFS with default sort order
-    std::future<void> future =
-        pool.submit_task([this, &g, &stop, &resultPromise, strongCheck]() {
-            DFSContext currentDrawState = createDFSContext();
-            bool result =
-                dfs(g, allGames, currentDrawState, 0, strongCheck, stop);
-            bool expected = false;
-            if (stop.compare_exchange_strong(expected, true)) {
-                resultPromise.set_value(result);
-            }
-        });
+// i-th term (1-based) of the Luby sequence: 1, 1, 2, 1, 1, 2, 4, 1, ...
+static uint64_t luby(uint64_t i) {
+    while (true) {
+        int k = 1;
+        while ((uint64_t{1} << k) - 1 < i) {
+            k++;
+        }
+        if ((uint64_t{1} << k) - 1 == i) {
+            return uint64_t{1} << (k - 1);
+        }
+        i -= (uint64_t{1} << (k - 1)) - 1;
+    }
+}
 
-    // wait up to 250ms for default DFS
-    if (resultFuture.wait_for(std::chrono::milliseconds(250)) ==
-        std::future_status::ready) {
-        // result returned by DFS within 250ms
-        stop.store(true, std::memory_order_relaxed);
-        future.wait();
-        return resultFuture.get();
-    }
-
-    // default DFS hasn't finished, launch extra workers with different sort
-    // orders
-    std::vector<std::future<void>> futures;
-    for (int sortMode = 1; sortMode < 3; sortMode++) {
-        futures.push_back(pool.submit_task([this, sortMode, &g, &stop,
-                                            &resultPromise, strongCheck]() {
-            DFSContext currentDrawState = createDFSContext();
-            bool result =
-                dfs(g, allGames, currentDrawState, sortMode, strongCheck, stop);
-            bool expected = false;
-            if (stop.compare_exchange_strong(expected, true)) {
-                resultPromise.set_value(result);
-            }
-        }));
-    }
-
-    // // wait until any thread finishes (no timeouts)
-    // resultFuture.wait();
-    // stop.store(true, std::memory_order_relaxed);
-    // future.wait();
-    // for (auto &f : futures) {
-    //     f.wait();
-    // }
-    // return resultFuture.get();
-
-    // wait until result or deadline
-    if (resultFuture.wait_until(deadline) == std::future_status::ready) {
-        // result returned before timeout
-        stop.store(true, std::memory_order_relaxed);
-        future.wait();
-        for (auto &f : futures) {
-            f.wait();
+template <typename Format>
+template <typename RunPortfolio>
+bool DrawEngine<Format>::dfsRestarts(RunPortfolio runPortfolio) const {
+    // run portfolios until one decides the test, with node budgets following
+    // the Luby sequence (in units of restartNodes) until timeoutNodes are
+    // spent; a test with a heavy-tailed search time is likelier to finish
+    // in one of many short, differently ordered runs than in one long run
+    // - restarts after the first break ordering ties differently
+    // - nogoods learned by earlier runs are kept in the feasibility cache
+    auto deadline = std::chrono::steady_clock::now() + dfsBudget.timeout;
+    uint64_t spent = 0;
+    for (uint64_t restart = 0; spent < dfsBudget.timeoutNodes; restart++) {
+        DFSBudget budget = dfsBudget;
+        if (dfsBudget.restartNodes) {
+            budget.timeoutNodes =
+                std::min(dfsBudget.restartNodes * luby(restart + 1),
+                         dfsBudget.timeoutNodes - spent);
+            budget.expandNodes =
+                std::min(dfsBudget.expandNodes, budget.timeoutNodes / 2);
         }
-        return resultFuture.get();
-    } else {
-        // timeout
-        stop.store(true, std::memory_order_relaxed);
-        future.wait();
-        for (auto &f : futures) {
-            f.wait();
+        spent += budget.timeoutNodes;
+        int result = runPortfolio(budget, restart * 0x9E3779B97F4A7C15ULL,
+                                  deadline);
+        if (result != -1) {
+            return result;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
         }
-        throw TimeoutException();
     }
+    throw TimeoutException();
+}
+
+template <typename Format>
+bool DrawEngine<Format>::testCandidateGame(const Game &g, Scheduler &scheduler,
+                                           bool strongCheck,
+                                           std::vector<Game> *witness) const {
+    // g is candidate game
+    // return true if valid game, false if invalid, throw TimeoutException if
+    // timeout
+    // if witness is set, the games of accepted paths are appended to it
+    return dfsRestarts([this, &g, &scheduler, strongCheck, witness](
+                           const DFSBudget &budget, uint64_t salt,
+                           std::chrono::steady_clock::time_point deadline) {
+        return runPortfolio(g, scheduler, strongCheck, budget, salt, deadline,
+                            witness);
+    });
+}
+
+template <typename Format>
+int DrawEngine<Format>::runPortfolio(
+    const Game &g, Scheduler &scheduler, bool strongCheck,
+    const DFSBudget &budget, uint64_t salt,
+    std::chrono::steady_clock::time_point deadline,
+    std::vector<Game> *witness) const {
+    // return 1 if valid game, 0 if invalid, -1 if every search gave up
+    DFSPortfolio portfolio(this, g, strongCheck, budget, &scheduler,
+                           *portfolioStats, salt, deadline);
+    portfolio.witness = witness;
+
+    // DFS with slot 0's ordering runs on this worker; after expandNodes, it
+    // spawns searches with the other slots' orderings for idle workers to
+    // steal (see dfsPoll)
+    dfsSearch(portfolio, 0);
+
+    // if slot 0 gave up, spawned searches keep going until one finishes
+    // or all give up; run any that weren't stolen instead of blocking
+    scheduler.helpWhile([&portfolio]() {
+        return portfolio.numSpawned.load(std::memory_order_acquire) > 0;
+    });
+
+    portfolioStats->record(portfolio.orderings.data(), DFSPortfolio::NUM_SLOTS,
+                           portfolio.expanded.load(std::memory_order_relaxed),
+                           portfolio.winner, portfolio.answerNodes);
+    return portfolio.result.load(std::memory_order_relaxed);
 }
 
-Game Draw::pickGame() const {
+template <typename Format>
+Game DrawEngine<Format>::pickGame(
+    const std::vector<Game> &remainingGames) const {
     // used in debug to pick next game (does not nec. involve picked team)
     // no thread pools: use raw threads for inner DFS
 
-    std::vector<Game> orderedRemainingGames(allGames);
+    std::vector<Game> orderedRemainingGames(remainingGames);
 
     // sort remaining games by home pot, then away pot
     std::stable_sort(orderedRemainingGames.begin(), orderedRemainingGames.end(),
@@ -609,7 +1208,7 @@ Game Draw::pickGame() const {
         // perform "weak" checking first (each team needing away/home game
         // against g.h/g.a pot must have >= 1 valid matchup left), which should
         // be ok >80% of the time; if this leads to timeout, repeat with
-        // "strong" checking (global country checks)
+        // "strong" checking (per pot group flow networks with country caps)
         try {
             if (testCandidateGame(g, false)) {
                 return g;
@@ -625,88 +1224,74 @@ Game Draw::pickGame() const {
     exit(2);
 }
 
-bool Draw::testCandidateGame(const Game &g, bool strongCheck) const {
+template <typename Format>
+bool DrawEngine<Format>::testCandidateGame(const Game &g,
+                                           bool strongCheck) const {
     // g is candidate game
     // return true if valid game, false if invalid, throw TimeoutException if
     // timeout
-    std::atomic<bool> stop{false};
-    std::chrono::steady_clock::time_point deadline =
-        std::chrono::steady_clock::now() + std::chrono::milliseconds(2500);
-    std::promise<bool> resultPromise;
-    std::shared_future<bool> resultFuture = resultPromise.get_future().share();
-
-    // DFS with default sort order
-    std::thread monitor([this, &g, &stop, &resultPromise, strongCheck]() {
-        DFSContext currentDrawState = createDFSContext();
-        bool result = dfs(g, allGames, currentDrawState, 0, strongCheck, stop);
-        bool expected = false;
-        if (stop.compare_exchange_strong(expected, true)) {
-            resultPromise.set_value(result);
-        }
+    return dfsRestarts([this, &g, strongCheck](
+                           const DFSBudget &budget, uint64_t salt,
+                           std::chrono::steady_clock::time_point deadline) {
+        return runPortfolio(g, strongCheck, budget, salt, deadline);
     });
+}
 
-    // wait up to 250ms for default DFS
-    if (resultFuture.wait_for(std::chrono::milliseconds(250)) ==
-        std::future_status::ready) {
-        // result returned by DFS within 250ms
-        stop.store(true, std::memory_order_relaxed);
-        monitor.join();
-        return resultFuture.get();
+template <typename Format>
+int DrawEngine<Format>::runPortfolio(
+    const Game &g, bool strongCheck, const DFSBudget &budget, uint64_t salt,
+    std::chrono::steady_clock::time_point deadline) const {
+    // return 1 if valid game, 0 if invalid, -1 if every search gave up
+    DFSPortfolio portfolio(this, g, strongCheck, budget, nullptr,
+                           *portfolioStats, salt, deadline);
+
+    // DFS with slot 0's ordering
+    std::thread monitor([this, &portfolio]() { dfsSearch(portfolio, 0); });
+
+    // wait until default DFS finishes or has searched expandNodes
+    while (!portfolio.stop.load(std::memory_order_relaxed) &&
+           !portfolio.expanded.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
 
-    // default DFS hasn't finished, launch extra workers with different sort
-    // orders
+    // default DFS hasn't finished, launch extra workers with the other slots'
+    // orderings
     std::vector<std::thread> workers;
-    for (int sortMode = 1; sortMode < 3; sortMode++) {
-        workers.emplace_back([this, sortMode, &g, &stop, &resultPromise,
-                              strongCheck]() {
-            DFSContext currentDrawState = createDFSContext();
-            bool result =
-                dfs(g, allGames, currentDrawState, sortMode, strongCheck, stop);
-            bool expected = false;
-            if (stop.compare_exchange_strong(expected, true)) {
-                resultPromise.set_value(result);
-            }
-        });
+    if (!portfolio.stop.load(std::memory_order_relaxed)) {
+        for (int slot = 1; slot < DFSPortfolio::NUM_SLOTS; slot++) {
+            workers.emplace_back([this, slot, &portfolio]() {
+                dfsSearch(portfolio, slot);
+            });
+        }
     }
 
-    // // wait until any thread finishes (no timeouts)
-    // resultFuture.wait();
-    // stop.store(true, std::memory_order_relaxed);
-    // monitor.join();
-    // for (auto &t : workers) {
-    //     t.join();
-    // }
-    // return resultFuture.get();
-
-    // wait until result or deadline
-    if (resultFuture.wait_until(deadline) == std::future_status::ready) {
-        // result returned before timeout
-        stop.store(true, std::memory_order_relaxed);
-        monitor.join();
-        for (auto &t : workers) {
-            t.join();
-        }
-        return resultFuture.get();
-    } else {
-        // timeout
-        stop.store(true, std::memory_order_relaxed);
-        monitor.join();
-        for (auto &t : workers) {
-            t.join();
-        }
-        throw TimeoutException();
+    // searches stop by themselves once one finishes, or give up once their
+    // node budget (or deadline) is spent
+    monitor.join();
+    for (auto &t : workers) {
+        t.join();
     }
+
+    portfolioStats->record(portfolio.orderings.data(), DFSPortfolio::NUM_SLOTS,
+                           portfolio.expanded.load(std::memory_order_relaxed),
+                           portfolio.winner, portfolio.answerNodes);
+    return portfolio.result.load(std::memory_order_relaxed);
 }
 
-bool Draw::dfs(const Game &g, const std::vector<Game> &remainingGames,
-               DFSContext &context, int sortMode, bool strongCheck,
-               std::atomic<bool> &stop) const {
+template <typename Format>
+bool DrawEngine<Format>::dfs(const Game &g, DFSSearch &search) const {
     // g is candidate game
     // return true if timeout, another thread finished, or g accepted
+    DFSContext &context = search.context;
+    DFSTrail &trail = search.trail;
+    std::atomic<bool> &stop = search.portfolio.stop;
+
+    if (++search.numNodes % DFS_POLL_NODES == 0) {
+        dfsPoll(search);
+    }
 
-    // timeout, or another thread finished:
-    if (stop.load(std::memory_order_relaxed)) {
+    // timeout, another thread finished, or node budget spent:
+    if (stop.load(std::memory_order_relaxed) || search.exhausted) {
         return true;
     }
 
@@ -717,34 +1302,39 @@ bool Draw::dfs(const Game &g, const std::vector<Game> &remainingGames,
 
     // tentatively pick g, then perform checks; if any check fails, revert state
     // and reject
-    dfsUpdateDrawState(g, context);
+    size_t mark = trail.mark();
+    dfsUpdateDrawState(g, context, trail);
 
     // accept:
-    if (context.pickedGames.size() ==
-        static_cast<size_t>(numTeams * numGamesPerTeam / 2)) {
+    if (context.numPickedGames == TEAMS * GAMES_PER_TEAM / 2) {
+        dfsRecordWitness(g, search);
         return true;
     }
 
+    // state already proven (in)feasible by an earlier search:
+    FeasibilityCache::Verdict verdict = feasibilityCache->lookup(context.hash);
+    if (verdict != FeasibilityCache::UNKNOWN) {
+        if (verdict == FeasibilityCache::FEASIBLE) {
+            dfsRecordWitness(g, search);
+        }
+        trail.undo(mark);
+        return verdict == FeasibilityCache::FEASIBLE;
+    }
+
     // weak checking (faster, but less pruning):
     if (!dfsWeakCheck(g, context)) {
-        dfsUpdateDrawState(g, context, true);
+        trail.undo(mark);
         return false;
     }
 
     // strong checking (slower, but more pruning):
-    if (strongCheck && !dfsStrongCheck(context)) {
-        dfsUpdateDrawState(g, context, true);
+    if (search.portfolio.strongCheck && !dfsFlowCheck(context, trail)) {
+        trail.undo(mark);
         return false;
     }
 
     // recursive case: g picked
     // recurse, then revert state
-    std::vector<Game> newRemainingGames;
-    std::copy_if(remainingGames.begin(), remainingGames.end(),
-                 std::back_inserter(newRemainingGames),
-                 [this, &context](const Game &rG) {
-                     return dfsValidRemainingGame(rG, context);
-                 });
 
     // pick new home team by getting minimum pot pair with unallocated games and
     // taking incomplete home pot team whose country has most teams
@@ -753,11 +1343,9 @@ bool Draw::dfs(const Game &g, const std::vector<Game> &remainingGames,
     int potPairHomePot = 0; // 1-indexed
     int potPairAwayPot = 0; // 1-indexed
     bool done = false;
-    for (int i = 1; i <= numPots; i++) {
-        for (int j = 1; j <= numPots; j++) {
-            if (context.numGamesByPotPair[std::to_string(i) + ":" +
-                                          std::to_string(j)] <
-                numGamesPerPotPair) {
+    for (int i = 1; i <= POTS; i++) {
+        for (int j = 1; j <= POTS; j++) {
+            if (context.numGamesByPotPair[i - 1][j - 1] < GAMES_PER_POT_PAIR) {
                 potPairHomePot = i;
                 potPairAwayPot = j;
                 done = true;
@@ -771,18 +1359,18 @@ bool Draw::dfs(const Game &g, const std::vector<Game> &remainingGames,
     // sort home pot's team indices by country with most teams, then take first
     // team with missing games against away pot (pot pairing for UECL)
     int newHomeTeamIndex = -1;
-    std::vector<int> teamIndices(numTeamsPerPot);
+    std::array<int, TEAMS_PER_POT> teamIndices;
     std::iota(teamIndices.begin(), teamIndices.end(),
-              (potPairHomePot - 1) * numTeamsPerPot);
+              (potPairHomePot - 1) * TEAMS_PER_POT);
     std::sort(
         teamIndices.begin(), teamIndices.end(),
         [this, &context, potPairAwayPot](int team1, int team2) {
-            //   return numTeamsByCountry[teams[team1].country] >
-            //          numTeamsByCountry[teams[team2].country];
-            return context.countryHomeNeeds[teams[team1].country + ":" +
-                                            std::to_string(potPairAwayPot)] <
-                   context.countryHomeNeeds[teams[team2].country + ":" +
-                                            std::to_string(potPairAwayPot)];
+            //   return numTeamsByCountry[teamCountryIds[team1]] >
+            //          numTeamsByCountry[teamCountryIds[team2]];
+            return context.countryHomeNeeds[teamCountryIds[team1]]
+                                           [potPairAwayPot - 1] <
+                   context.countryHomeNeeds[teamCountryIds[team2]]
+                                           [potPairAwayPot - 1];
         });
     for (int t : teamIndices) {
         if (dfsHomeTeamPredicate(t, potPairAwayPot, context)) {
@@ -791,61 +1379,84 @@ bool Draw::dfs(const Game &g, const std::vector<Game> &remainingGames,
         }
     }
 
-    // stable sort remaining games to improve performance
-    std::vector<Game> candidateGames(newRemainingGames);
-    dfsSortRemainingGames(candidateGames, context, sortMode);
-
-    // filter candidates to only include games involving new home team and
-    // matching away pot
-    for (const Game &cG : candidateGames) {
-        if (cG.h == newHomeTeamIndex && teams[cG.a].pot == potPairAwayPot) {
-            if (dfs(cG, newRemainingGames, context, sortMode, strongCheck,
-                    stop)) {
-                // accept, timeout, or another thread finished
-                // revert state and immediately return
-                dfsUpdateDrawState(g, context, true);
-                return true;
+    // candidates are remaining games involving new home team and matching
+    // away pot, read directly from new home team's legal opps
+    // - frame scratch lives on the call stack (bounded by TEAMS_PER_POT), so
+    //   frames are released in LIFO order without touching the heap
+    std::array<Game, TEAMS_PER_POT> candidateGames;
+    int numCandidateGames = 0;
+    if (newHomeTeamIndex != -1) {
+        uint64_t awayTeams = context.legalAwayOppsByTeamInd[newHomeTeamIndex] &
+                             teamsByPot[potPairAwayPot - 1];
+        for (; awayTeams; awayTeams &= awayTeams - 1) {
+            candidateGames[numCandidateGames++] =
+                Game(newHomeTeamIndex, __builtin_ctzll(awayTeams));
+        }
+    }
+
+    // stable sort candidate games to improve performance
+    dfsSortRemainingGames(candidateGames.data(),
+                          candidateGames.data() + numCandidateGames, context,
+                          search.ordering, search.portfolio.salt);
+
+    // register frame, so dfsSplit can hand its untried candidates to idle
+    // workers
+    DFSFrame frame{g, candidateGames.data(), 0, numCandidateGames};
+    search.frames[search.numFrames++] = &frame;
+
+    for (; frame.next < frame.end; frame.next++) {
+        const Game &cG = candidateGames[frame.next];
+        if (dfs(cG, search)) {
+            // accept, timeout, another thread finished, or node budget spent
+            // (only accept if neither stop nor exhausted is set, since one is
+            // set before dfs ever returns true spuriously and is never reset)
+            if (!stop.load(std::memory_order_relaxed) && !search.exhausted) {
+                feasibilityCache->record(context.hash,
+                                         FeasibilityCache::FEASIBLE);
             }
+            // revert state and immediately return
+            search.numFrames--;
+            trail.undo(mark);
+            return true;
         }
     }
+    search.numFrames--;
 
-    // no valid candidate game, so reject
-    dfsUpdateDrawState(g, context, true);
+    // no valid candidate game, so reject (false is never returned spuriously,
+    // so state is proven infeasible, unless candidates were split off)
+    if (!frame.split) {
+        feasibilityCache->record(context.hash, FeasibilityCache::INFEASIBLE);
+    }
+    trail.undo(mark);
     // std::cout << "\t\t\treject (exhausted candidates)" << std::endl;
     return false;
 }
 
-bool Draw::dfsWeakCheck(const Game &g, const DFSContext &context) const {
+template <typename Format>
+bool DrawEngine<Format>::dfsWeakCheck(const Game &g,
+                                      const DFSContext &context) const {
     // return true if checks passed; false if any check failed
 
     // - each team needing away game against g.h pot must have >= 1 valid
     //   matchup left; otherwise, return false
-    for (int teamInd : context.needsAwayAgainstPot[teams[g.h].pot - 1]) {
-        bool validMatchup = false;
-        for (int i = 0; i < numTeamsPerPot; i++) {
-            int homeTeamInd = (teams[g.h].pot - 1) * numTeamsPerPot + i;
-            if (dfsValidRemainingGame(Game(homeTeamInd, teamInd), context)) {
-                validMatchup = true;
-                break;
-            }
-        }
-        if (!validMatchup) {
+    uint64_t homePotTeams =
+        teamsInPots(PotPolicy::potGroup(teams[g.h].pot - 1));
+    uint64_t needy = context.needsAwayAgainstPot[teams[g.h].pot - 1];
+    for (; needy; needy &= needy - 1) {
+        int teamInd = __builtin_ctzll(needy);
+        if (!(context.legalHomeOppsByTeamInd[teamInd] & homePotTeams)) {
             return false;
         }
     }
 
     // - each team needing home game against g.a pot must have >= 1 valid
     //   matchup left; otherwise, return false
-    for (int teamInd : context.needsHomeAgainstPot[teams[g.a].pot - 1]) {
-        bool validMatchup = false;
-        for (int i = 0; i < numTeamsPerPot; i++) {
-            int awayTeamInd = (teams[g.a].pot - 1) * numTeamsPerPot + i;
-            if (dfsValidRemainingGame(Game(teamInd, awayTeamInd), context)) {
-                validMatchup = true;
-                break;
-            }
-        }
-        if (!validMatchup) {
+    uint64_t awayPotTeams =
+        teamsInPots(PotPolicy::potGroup(teams[g.a].pot - 1));
+    needy = context.needsHomeAgainstPot[teams[g.a].pot - 1];
+    for (; needy; needy &= needy - 1) {
+        int teamInd = __builtin_ctzll(needy);
+        if (!(context.legalAwayOppsByTeamInd[teamInd] & awayPotTeams)) {
             return false;
         }
     }
@@ -853,216 +1464,249 @@ bool Draw::dfsWeakCheck(const Game &g, const DFSContext &context) const {
     return true;
 }
 
-bool Draw::dfsStrongCheck(const DFSContext &context) const {
+template <typename Format>
+bool DrawEngine<Format>::dfsFlowCheck(DFSContext &context,
+                                      DFSTrail &trail) const {
     // return true if checks passed; false if any check failed
 
-    // - for each country and each pot, country's home games needed against the
-    //   pot and country's away games needed against the pot must not exceed
-    //   respective supply
-    for (auto &p : teamIndsByCountry) {
-        std::string country = p.first;
-        std::vector<int> countryTeamInds = p.second;
-        for (int pot = 1; pot <= numPots; pot++) {
-            // remaining # of home games this country needs against this pot
-            int homeDemand = context.countryHomeNeeds.at(country + ":" +
-                                                         std::to_string(pot));
-
-            // conservatively high est of avail slots this pot can provide
-            // to this country for home games
-            int homeSlots = 0;
-
-            // remaining # of away games this country needs against this pot
-            int awayDemand = context.countryAwayNeeds.at(country + ":" +
-                                                         std::to_string(pot));
-
-            // conservatively high est of avail slots this pot can provide
-            // to this country for away games
-            int awaySlots = 0;
-
-            // compute total homeSlots and awaySlots this pot can provide
-            for (int i = 0; i < numTeamsPerPot; i++) {
-                int potTeamInd = numTeamsPerPot * (pot - 1) + i;
-
-                // available home slots provided by this pot team
-                int homeSlotsTeam = 0;
-
-                // available away slots provided by this pot team
-                int awaySlotsTeam = 0;
-
-                // this pot team can contribute up to maxSlotsTeam to pot's
-                // total home or away slots
-                int maxSlotsTeam =
-                    2 - get_or(context.numGamesByTeamIndOppCountry,
-                               std::to_string(potTeamInd) + ":" + country, 0);
-
-                // compute # of home slots and away slots this pot team can
-                // provide
-                for (const int &countryTeamInd : countryTeamInds) {
-                    if (dfsValidRemainingGame(Game(countryTeamInd, potTeamInd),
-                                              context)) {
-                        homeSlotsTeam =
-                            std::min(maxSlotsTeam, homeSlotsTeam + 1);
-                    }
-                    if (dfsValidRemainingGame(Game(potTeamInd, countryTeamInd),
-                                              context)) {
-                        awaySlotsTeam =
-                            std::min(maxSlotsTeam, awaySlotsTeam + 1);
-                    }
-                }
-                homeSlots += homeSlotsTeam;
-                awaySlots += awaySlotsTeam;
-            }
-            if (homeDemand > homeSlots || awayDemand > awaySlots) {
-                return false;
-            }
+    // - for each pot group (pot pairing for UECL) and location, the group's
+    //   teams (left, capacity: remaining games at location) and the opps
+    //   needing a game against the group at the other location (right,
+    //   capacity 1) form a bipartite flow network; a left team's edges to a
+    //   country pass through a gadget whose capacity is the # of games the
+    //   team may still play against the country
+    // - state is infeasible if any network's max flow is below its # of right
+    //   teams
+    // - flows are kept in context and repaired from the parent node's flows,
+    //   since only edges and capacities involving the last picked game's teams
+    //   change between neighbouring nodes
+    for (int pot = 0; pot < POTS; pot++) {
+        if (PotPolicy::potGroup(pot) & ((1 << pot) - 1)) {
+            continue; // one network per group, keyed by its lowest pot
+        }
+        if (!dfsRepairFlow(pot, HOME, context, trail) ||
+            !dfsRepairFlow(pot, AWAY, context, trail)) {
+            return false;
         }
     }
     return true;
 }
 
-bool Draw::dfsHomeTeamPredicate(int homeTeamIndex, int awayPot,
-                                const DFSContext &context) const {
-    // return true to use new home team, false to reject
-    return !get_or(context.isPickedByTeamIndOppPotLocation,
-                   std::to_string(homeTeamIndex) + ":" +
-                       std::to_string(awayPot) + ":h",
-                   false);
-}
-
-void Draw::displayPots(bool showCountries) const {
-    std::cout << "Games: " << pickedGames.size() << std::endl << std::endl;
-
-    for (int i = 0; i < numPots; i++) {
-        std::cout << POT_COLORS[i] << "Pot " << i + 1 << RESET << std::endl;
-        for (int j = 0; j < numTeamsPerPot; j++) {
-            int teamInd = i * numTeamsPerPot + j;
-            std::cout << teams[teamInd].abbrev;
-            if (showCountries) {
-                std::cout << GRAY << "(" << toLower(teams[teamInd].country)
-                          << ")" << RESET;
-            }
-            std::cout << "\t";
-            std::vector<Game> teamGames = gamesByTeamInd.at(teamInd);
-            std::stable_sort(teamGames.begin(), teamGames.end(),
-                             [this, teamInd](const Game &g1, const Game &g2) {
-                                 // order by opponent pot
-                                 int oppInd1 = (g1.h == teamInd) ? g1.a : g1.h;
-                                 int oppInd2 = (g2.h == teamInd) ? g2.a : g2.h;
-                                 return teams[oppInd1].pot < teams[oppInd2].pot;
-                             });
-            for (size_t k = 0; k < teamGames.size(); k++) {
-                Game g = teamGames[k];
-                int oppInd = (g.h == teamInd) ? g.a : g.h;
-                std::cout << POT_COLORS[teams[oppInd].pot - 1]
-                          << teams[oppInd].abbrev << RESET;
-                if (showCountries) {
-                    std::cout << GRAY << "(" << toLower(teams[oppInd].country)
-                              << "."
-                              << numGamesByTeamIndOppCountry.at(
-                                     std::to_string(teamInd) + ":" +
-                                     teams[oppInd].country)
-                              << ")" << RESET;
-                }
-                std::cout << ((g.h == teamInd) ? "h" : "a");
-                if (k < teamGames.size() - 1) {
-                    std::cout << ",";
-                }
+template <typename Format>
+bool DrawEngine<Format>::dfsRepairFlow(int pot, int location,
+                                       DFSContext &context,
+                                       DFSTrail &trail) const {
+    // repair flow network of pot's group at location, then augment it until
+    // every right team is routed; return false if that is impossible
+    std::array<uint64_t, MAX_TEAMS> &contextFlows =
+        location == HOME ? context.homeFlowByTeamInd
+                         : context.awayFlowByTeamInd;
+    uint64_t lefts = teamsInPots(PotPolicy::potGroup(pot));
+    uint64_t rights = location == HOME ? context.needsAwayAgainstPot[pot]
+                                       : context.needsHomeAgainstPot[pot];
+
+    // drop flow through edges that are no longer legal, and through gadgets
+    // and left teams that are over capacity
+    std::array<uint64_t, MAX_TEAMS> flows;
+    uint64_t routed = 0;
+    for (uint64_t ls = lefts; ls; ls &= ls - 1) {
+        int t = __builtin_ctzll(ls);
+        uint64_t flow = contextFlows[t] & rights & ~routed &
+                        dfsFlowOpps(t, location, context);
+        for (uint64_t rest = flow; rest;) {
+            int country = teamCountryIds[__builtin_ctzll(rest)];
+            uint64_t countryFlow = flow & teamsByCountry[country];
+            rest &= ~teamsByCountry[country];
+            int excess = __builtin_popcountll(countryFlow) -
+                         (2 - numGamesAgainstCountry(t, country, context));
+            for (; excess > 0; excess--) {
+                flow &= ~(countryFlow & -countryFlow);
+                countryFlow &= countryFlow - 1;
             }
-            std::cout << std::endl;
         }
-        std::cout << std::endl;
-    }
-}
-
-bool Draw::verifyDraw() const {
-    // check for correct total number of games
-    size_t numExpectedGames = numTeams * numGamesPerTeam / 2;
-    if (pickedGames.size() != numExpectedGames) {
-        if (!suppress)
-            std::cout << "INVALID DRAW: drew " << pickedGames.size()
-                      << " games but expected " << numExpectedGames << "."
-                      << std::endl;
-        return false;
+        int excess = __builtin_popcountll(flow) -
+                     dfsFlowCapacity(t, location, context);
+        for (; excess > 0; excess--) {
+            flow &= flow - 1;
+        }
+        flows[t] = flow;
+        routed |= flow;
     }
 
-    std::unordered_map<int, TeamVerifier> m; // team ind -> TeamVerifier
-    for (const Game &g : pickedGames) {
-        // check for no opp from own country
-        if (teams[g.h].country == teams[g.a].country) {
-            if (!suppress)
-                std::cout << "INVALID DRAW: same country ("
-                          << teams[g.h].country << ")- " << teams[g.h].abbrev
-                          << " has been drawn against " << teams[g.a].abbrev
-                          << "." << std::endl;
+    // route remaining right teams
+    for (int unrouted = __builtin_popcountll(rights & ~routed); unrouted > 0;
+         unrouted--) {
+        if (!dfsAugmentFlow(lefts, rights, location, flows, context)) {
             return false;
         }
-        m[g.h].oppTeamInds.insert(g.a);
-        m[g.h].numGamesByPot[teams[g.a].pot] += 1;
-        m[g.a].oppTeamInds.insert(g.h);
-        m[g.a].numGamesByPot[teams[g.h].pot] += 1;
+    }
 
-        // check for no more than 2 opps from same country
-        m[g.h].numOppsByCountry[teams[g.a].country] += 1;
-        m[g.a].numOppsByCountry[teams[g.h].country] += 1;
-        if (m[g.h].numOppsByCountry[teams[g.a].country] > 2 ||
-            m[g.a].numOppsByCountry[teams[g.h].country] > 2) {
-            if (!suppress)
-                std::cout << "INVALID DRAW: > 2 country limit exceeded"
-                          << std::endl;
-            return false;
-        }
+    for (uint64_t ls = lefts; ls; ls &= ls - 1) {
+        int t = __builtin_ctzll(ls);
+        trail.set(contextFlows[t], flows[t]);
+    }
+    return true;
+}
 
-        if (!verifyDrawHomeAway(m, g.h, g.a)) {
-            return false;
+template <typename Format>
+bool DrawEngine<Format>::dfsAugmentFlow(
+    uint64_t lefts, uint64_t rights, int location,
+    std::array<uint64_t, MAX_TEAMS> &flows, const DFSContext &context) const {
+    // BFS from source for a residual path to an unrouted right team, then
+    // augment along it; return false if no such path exists
+    // - nodes are left teams, gadgets (left team, country) and right teams
+    // - flows[t] holds the right teams routed through left team t, which
+    //   determines the flow on every edge
+    enum { LEFT, GADGET, RIGHT };
+    struct FlowNode {
+        int kind;
+        int team;    // left team (LEFT, GADGET) or right team (RIGHT)
+        int country; // GADGET only
+        int parent;  // index into queue, -1 for source
+    };
+    constexpr int GROUP_TEAMS =
+        TEAMS_PER_POT * __builtin_popcount(PotPolicy::potGroup(0));
+    std::array<FlowNode, GROUP_TEAMS *(TEAMS + 1) + TEAMS> queue;
+    int head = 0;
+    int tail = 0;
+
+    std::array<int, MAX_TEAMS> hosts; // right team -> left team routing it
+    uint64_t routed = 0;
+    for (uint64_t ls = lefts; ls; ls &= ls - 1) {
+        int t = __builtin_ctzll(ls);
+        for (uint64_t rs = flows[t]; rs; rs &= rs - 1) {
+            hosts[__builtin_ctzll(rs)] = t;
         }
+        routed |= flows[t];
     }
 
-    int oppsPerPot = numGamesPerTeam / numPots;
-    for (auto &[teamInd, teamVerifierObj] : m) {
-        // check for correct total num of opps
-        if (teamVerifierObj.oppTeamInds.size() !=
-            static_cast<size_t>(numGamesPerTeam)) {
-            if (!suppress)
-                std::cout << "INVALID DRAW: " << teams[teamInd].abbrev
-                          << " has been drawn against "
-                          << teamVerifierObj.oppTeamInds.size()
-                          << " opponents (expected " << numGamesPerTeam << ")."
-                          << std::endl;
-            return false;
+    uint64_t visitedLefts = 0;
+    uint64_t visitedRights = 0;
+    std::array<uint64_t, MAX_TEAMS> visitedGadgets{}; // left team -> countries
+    for (uint64_t ls = lefts; ls; ls &= ls - 1) {
+        int t = __builtin_ctzll(ls);
+        if (__builtin_popcountll(flows[t]) <
+            dfsFlowCapacity(t, location, context)) {
+            visitedLefts |= uint64_t{1} << t;
+            queue[tail++] = {LEFT, t, -1, -1};
         }
+    }
 
-        // check for correct num of opps per pot
-        for (int i = 1; i <= numPots; i++) {
-            if (teamVerifierObj.numGamesByPot[i] != oppsPerPot) {
-                if (!suppress)
-                    std::cout << "INVALID DRAW: " << teams[teamInd].abbrev
-                              << " has been drawn against "
-                              << teamVerifierObj.numGamesByPot[i]
-                              << " clubs in Pot " << i + 1 << " (expected "
-                              << oppsPerPot << ")." << std::endl;
-                return false;
+    while (head < tail) {
+        int index = head++;
+        const FlowNode node = queue[index];
+        if (node.kind == LEFT) {
+            // forward to gadgets with spare capacity leading to new opps
+            int t = node.team;
+            uint64_t opps =
+                dfsFlowOpps(t, location, context) & rights & ~flows[t];
+            for (; opps; opps &= ~teamsByCountry[teamCountryIds[
+                             __builtin_ctzll(opps)]]) {
+                int country = teamCountryIds[__builtin_ctzll(opps)];
+                if (!((visitedGadgets[t] >> country) & 1) &&
+                    __builtin_popcountll(flows[t] & teamsByCountry[country]) <
+                        2 - numGamesAgainstCountry(t, country, context)) {
+                    visitedGadgets[t] |= uint64_t{1} << country;
+                    queue[tail++] = {GADGET, t, country, index};
+                }
+            }
+        } else if (node.kind == GADGET) {
+            int t = node.team;
+            uint64_t countryTeams = teamsByCountry[node.country];
+            // forward to opps of gadget's country not yet routed to t
+            uint64_t opps = dfsFlowOpps(t, location, context) & rights &
+                            countryTeams & ~flows[t] & ~visitedRights;
+            for (; opps; opps &= opps - 1) {
+                int r = __builtin_ctzll(opps);
+                visitedRights |= uint64_t{1} << r;
+                if (!((routed >> r) & 1)) {
+                    // augment: walk back to source, moving each right team on
+                    // the path to the left team preceding it
+                    flows[t] |= uint64_t{1} << r;
+                    for (int i = index; queue[i].parent != -1;
+                         i = queue[i].parent) {
+                        const FlowNode &parent = queue[queue[i].parent];
+                        if (queue[i].kind == GADGET && parent.kind == RIGHT) {
+                            flows[queue[i].team] &=
+                                ~(uint64_t{1} << parent.team);
+                        } else if (queue[i].kind == RIGHT) {
+                            flows[parent.team] |= uint64_t{1} << queue[i].team;
+                        }
+                    }
+                    return true;
+                }
+                queue[tail++] = {RIGHT, r, -1, index};
+            }
+            // backward to t, if gadget carries flow
+            if (!((visitedLefts >> t) & 1) && (flows[t] & countryTeams)) {
+                visitedLefts |= uint64_t{1} << t;
+                queue[tail++] = {LEFT, t, -1, index};
+            }
+        } else {
+            // backward to gadget routing right team
+            int host = hosts[node.team];
+            int country = teamCountryIds[node.team];
+            if (!((visitedGadgets[host] >> country) & 1)) {
+                visitedGadgets[host] |= uint64_t{1} << country;
+                queue[tail++] = {GADGET, host, country, index};
             }
         }
     }
+    return false;
+}
 
-    if (!suppress)
-        std::cout << "Draw has been verified and is valid." << std::endl;
-    return true;
+template <typename Format>
+uint64_t DrawEngine<Format>::dfsFlowOpps(int teamIndex, int location,
+                                         const DFSContext &context) const {
+    // edges of team's node in flow network at location
+    return location == HOME ? context.legalAwayOppsByTeamInd[teamIndex]
+                            : context.legalHomeOppsByTeamInd[teamIndex];
 }
 
-bool Draw::verifyDrawHomeAway(std::unordered_map<int, TeamVerifier> &m,
-                              int homeTeamIndex, int awayTeamIndex) const {
-    // check for 1 home, 1 away game per pot for each team
-    std::string hp = std::to_string(teams[homeTeamIndex].pot);
-    std::string ap = std::to_string(teams[awayTeamIndex].pot);
-    if (m[homeTeamIndex].isPickedByOppPotLocation[ap + ":h"] ||
-        m[awayTeamIndex].isPickedByOppPotLocation[hp + ":a"]) {
-        if (!suppress)
-            std::cout << "INVALID DRAW: 1 home/1 away per pot violated"
-                      << std::endl;
-        return false;
+template <typename Format>
+int DrawEngine<Format>::dfsFlowCapacity(int teamIndex, int location,
+                                        const DFSContext &context) const {
+    // # games team still needs at location
+    return GAMES_PER_TEAM / 2 -
+           (location == HOME ? context.numHomeGamesByTeamInd[teamIndex]
+                             : context.numAwayGamesByTeamInd[teamIndex]);
+}
+
+template <typename Format>
+bool DrawEngine<Format>::dfsHomeTeamPredicate(
+    int homeTeamIndex, int awayPot, const DFSContext &context) const {
+    // return true to use new home team, false to reject
+    return !((context.blockedPotsByTeamIndLocation[homeTeamIndex][HOME] >>
+              (awayPot - 1)) &
+             1);
+}
+
+template <typename Format>
+bool DrawEngine<Format>::verifyDrawHomeAway(
+    std::unordered_map<int, TeamVerifier> &m, int homeTeamIndex,
+    int awayTeamIndex) const {
+    // check for 1 home, 1 away game per pot (pot pairing for UECL) for each
+    // team
+    int homePot = teams[homeTeamIndex].pot - 1;
+    int awayPot = teams[awayTeamIndex].pot - 1;
+    for (int pot = 0; pot < POTS; pot++) {
+        std::string p = std::to_string(pot + 1);
+        if ((((PotPolicy::potGroup(awayPot) >> pot) & 1) &&
+             m[homeTeamIndex].isPickedByOppPotLocation[p + ":h"]) ||
+            (((PotPolicy::potGroup(homePot) >> pot) & 1) &&
+             m[awayTeamIndex].isPickedByOppPotLocation[p + ":a"])) {
+            if (!suppress)
+                std::cout << "INVALID DRAW: 1 home/1 away per "
+                          << PotPolicy::NAME << " violated" << std::endl;
+            return false;
+        }
     }
-    m[homeTeamIndex].isPickedByOppPotLocation[ap + ":h"] = true;
-    m[awayTeamIndex].isPickedByOppPotLocation[hp + ":a"] = true;
+    m[homeTeamIndex]
+        .isPickedByOppPotLocation[std::to_string(awayPot + 1) + ":h"] = true;
+    m[awayTeamIndex]
+        .isPickedByOppPotLocation[std::to_string(homePot + 1) + ":a"] = true;
     return true;
-}
\ No newline at end of file
+}
+
+template class DrawEngine<UCLFormat>;
+template class DrawEngine<UECLFormat>;
@@ -1,64 +1,238 @@
 #ifndef DRAW_H
 #define DRAW_H
 
+#include "FeasibilityCache.h"
+#include "PhiloxEngine.h"
+#include "PortfolioStats.h"
+#include "Scheduler.h"
 #include "globals.h"
-#include <BS_thread_pool/BS_thread_pool.hpp>
 #include <atomic>
 #include <chrono>
 #include <exception>
-#include <random>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+// pot pairing policies, used by DrawEngine to decide which pots a team can no
+// longer face and which pots share needs
+// - pots are 0-based and pot sets are bitsets
+
+// 1 home, 1 away game per pot (UCL, UEL)
+struct SinglePotPolicy {
+    static constexpr const char *NAME = "pot";
+    // pots a team can no longer face at a location, given pots it has already
+    // played at that location (samePots) and at the other location
+    // (otherPots)
+    static constexpr uint8_t blockedPots(uint8_t samePots, uint8_t) {
+        return samePots;
+    }
+    // pots whose needs are shared with pot
+    static constexpr uint8_t potGroup(int pot) { return 1 << pot; }
+};
+
+// 1 home, 1 away game per pot pairing (1/2, 3/4, 5/6) (UECL)
+struct PairedPotPolicy {
+    static constexpr const char *NAME = "pot pairing";
+    static constexpr uint8_t pairedPots(uint8_t pots) {
+        return ((pots & 0x15) << 1) | ((pots & 0x2A) >> 1);
+    }
+    // a team that has played pot p at one location can no longer play p at
+    // the other location, nor p's paired pot at the same location
+    static constexpr uint8_t blockedPots(uint8_t samePots, uint8_t otherPots) {
+        return samePots | pairedPots(samePots) | otherPots;
+    }
+    static constexpr uint8_t potGroup(int pot) {
+        return (1 << pot) | pairedPots(1 << pot);
+    }
+};
+
+// compile-time draw format, used to specialize DrawEngine
+template <int Pots, int TeamsPerPot, int GamesPerTeam, int GamesPerPotPair,
+          typename Policy>
+struct DrawFormat {
+    static constexpr int POTS = Pots;
+    static constexpr int TEAMS_PER_POT = TeamsPerPot;
+    static constexpr int GAMES_PER_TEAM = GamesPerTeam;
+    static constexpr int GAMES_PER_POT_PAIR = GamesPerPotPair;
+    using PotPolicy = Policy;
+};
+
+using UCLFormat = DrawFormat<4, 9, 8, 9, SinglePotPolicy>;
+using UELFormat = DrawFormat<4, 9, 8, 9, SinglePotPolicy>;
+using UECLFormat = DrawFormat<6, 6, 6, 3, PairedPotPolicy>;
+
+// per-phase DFS node budgets for testing a candidate game, so that whether a
+// test times out doesn't depend on machine speed or load
+struct DFSBudget {
+    uint64_t expandNodes = 50000; // nodes portfolio slot 0 searches alone
+                                  // before siblings in other slots start
+    uint64_t nestedNodes = 5000;  // nodes a sibling nested on a busy worker
+                                  // searches before it nests the next one
+    uint64_t timeoutNodes = 250000; // nodes each search gets, over all
+                                    // restarts, before giving up (all give
+                                    // up -> timeout)
+    uint64_t restartNodes = 25000; // unit of the Luby sequence of restart
+                                   // budgets (0 -> no restarts)
+    std::chrono::milliseconds timeout{30000}; // wall-clock safety net
+};
+
+// DFS searches racing to test one candidate game, each with a different
+// candidate ordering (picked per slot by PortfolioStats); the first to finish
+// decides the result and stops the rest
+struct DFSPortfolio {
+    static constexpr int NUM_SLOTS = 3;
+
+    // argument of a spawned search (see DrawEngine::runPortfolioSearch)
+    struct Search {
+        DFSPortfolio *portfolio;
+        int slot;
+    };
+
+    DFSPortfolio(const void *e, const Game &g, bool s, const DFSBudget &b,
+                 Scheduler *sch, const PortfolioStats &stats, uint64_t sa,
+                 std::chrono::steady_clock::time_point d)
+        : engine(e), game(g), strongCheck(s), budget(b), scheduler(sch),
+          deadline(d), salt(sa) {
+        stats.choose(orderings.data(), NUM_SLOTS);
+        for (int i = 0; i < NUM_SLOTS; i++) {
+            searches[i] = {this, i};
+        }
+    }
+
+    const void *engine; // DrawEngine running the searches
+    Game game;          // candidate game
+    bool strongCheck;
+    DFSBudget budget;
+    Scheduler *scheduler; // runs siblings once slot 0 has searched
+                          // expandNodes (nullptr -> caller launches them)
+    std::chrono::steady_clock::time_point deadline; // wall-clock timeout
+    uint64_t salt; // breaks ordering ties if nonzero (differs per restart)
+    std::array<int, NUM_SLOTS> orderings;           // slot -> DFSOrdering
+    std::atomic<bool> stop{false}; // set once result known or timed out
+    std::atomic<int> result{-1};   // -1 timeout, 0 invalid, 1 valid
+    int winner = -1;               // slot that decided result (set with it)
+    uint64_t answerNodes = 0;      // nodes expanded by winner
+    std::atomic<bool> expanded{false};
+    std::atomic<int> numSpawned{0}; // spawned searches not yet returned
+    std::vector<Game> *witness = nullptr; // if set, gets the games of the
+                                          // first accepted path (see
+                                          // dfsRecordWitness)
+    std::atomic<bool> witnessRecorded{false};
+    std::array<Search, NUM_SLOTS> searches;
+
+    // shared by a slot's search and the subtrees split off it, which
+    // together search one tree
+    struct alignas(64) SplitGroup {
+        std::atomic<uint64_t> numNodes{0}; // nodes expanded (counted at
+                                           // each poll)
+        std::atomic<bool> exhausted{false}; // some member gave up, so an
+                                            // infeasible result is unproven
+    };
+    std::array<SplitGroup, NUM_SLOTS> groups;
+};
+
+// candidate loop of one dfs call, registered with its DFSSearch so that
+// untried candidates can be split off to idle workers
+struct DFSFrame {
+    Game game;         // game picked on entry
+    Game *candidates;  // in sort order
+    int next;          // candidate being tried
+    int end;           // candidates from end on were split off
+    bool split = false; // part of subtree is searched elsewhere, so a
+                        // rejection doesn't prove infeasibility
+};
+
+struct DFSSearch;
+
+// subtree split off a DFSSearch (see DrawEngine::dfsSplit)
+struct DFSSubtree {
+    DFSPortfolio *portfolio;
+    DFSSearch *donor; // waits for subtree before returning
+    int slot;
+    int pathLength;
+    std::array<Game, MAX_GAMES> path; // games picked after obj state; last
+                                      // is subtree's root
+};
+
+// state of one DFS search within a DFSPortfolio
+struct DFSSearch {
+    DFSContext context;
+    DFSTrail &trail;
+    int slot;
+    int ordering; // DFSOrdering of slot
+    DFSPortfolio &portfolio;
+    uint64_t sliceNodes;   // nodes before search starts/nests siblings
+    uint64_t numNodes = 0; // nodes expanded so far
+    bool exhausted = false; // gave up after budget.timeoutNodes
+    const Game *basePath = nullptr; // games picked before context's root
+    int basePathLength = 0;         // (subtrees only)
+    std::array<DFSFrame *, MAX_GAMES> frames{}; // dfs calls on current path
+    int numFrames = 0;
+    std::atomic<int> numSplit{0}; // split off subtrees not yet returned
+};
+
+// immutable inputs of a draw, shared by every Draw built from them (e.g. by
+// all draws of a Simulator run), so constructing or resetting a Draw doesn't
+// rebuild them
+struct DrawScenario {
+    std::vector<Team> teams;            // all Teams in draw
+    std::vector<std::string> countries; // country id -> country
+    std::vector<int> teamCountryIds;    // team ind -> country id
+    std::vector<int> numTeamsByCountry; // country id -> # teams
+    std::vector<std::vector<int>>
+        teamIndsByCountry;                // country id -> team inds
+    std::vector<uint64_t> teamsByPot;     // pot ind -> teams in pot
+    std::vector<uint64_t> teamsByCountry; // country id -> teams in country
+    std::vector<uint64_t> legalOppsByTeamInd; // team ind -> teams it may ever
+                                              // face (diff country, not
+                                              // banned)
+    DFSContext initialState; // before any game is picked (legal masks are
+                             // computed on reset)
+    uint64_t hash; // fingerprint of format, teams and legal opps (e.g. to
+                   // check that shards of a run simulated the same draw)
+};
+
 class Draw {
   public:
-    bool draw(); // used in debug; returns false if timeout
-    bool draw(BS::light_thread_pool &pool); // used in simulations
+    virtual ~Draw() = default;
+    virtual bool draw() = 0; // used in debug; returns false if timeout
+    virtual bool draw(Scheduler &scheduler) = 0; // used in simulations
+    // restart from initialGames, keeping scenario, caches and settings (e.g.
+    // to reuse one Draw for many simulations)
+    virtual void reset(const std::vector<Game> &initialGames) = 0;
     void displayPots(bool showCountries = false) const;
     const std::vector<Game> getPickedGames() const;
     bool verifyDraw() const;
+    void setFeasibilityCache(FeasibilityCache *cache); // e.g. shared by all
+                                                       // draws of a run
+    void setPortfolioStats(PortfolioStats *stats); // e.g. shared by all
+                                                   // draws of a run
+    void setDFSBudget(const DFSBudget &budget);
+    void setRandomStream(uint64_t key,
+                         uint64_t stream); // e.g. run seed, iteration
+    // Rao-Blackwellized estimator: at each simulated pick, credit every
+    // feasible game of the picked game's pot pair with its probability of
+    // being picked (see getPickCredits)
+    void setPickCredits(bool enabled);
+    // game h * numTeams + a -> sum over picks since reset of P(pick is game |
+    // draw state), an unbiased estimate of whether game is in the draw
+    const std::vector<double> &getPickCredits() const;
 
   protected:
-    Draw(const std::vector<Team> &t, const std::vector<Game> &initialGames,
-         const std::unordered_set<std::string> &bannedCountryMatchups, int pots,
-         int teamsPerPot, int gamesPerTeam, int gamesPerPotPair, bool suppress);
-    Draw(std::string teamsPath, std::string initialGamesPath,
-         std::string bannedCountryMatchupsPath, int pots, int teamsPerPot,
+    Draw(std::shared_ptr<const DrawScenario> sc, int pots, int teamsPerPot,
          int gamesPerTeam, int gamesPerPotPair, bool suppress);
 
-    void initializeState(
-        const std::vector<Game> &initialGames,
-        const std::unordered_set<std::string> &bannedCountryMatchups);
-    int pickTeamIndex(int pot);
-    Game pickGame() const;                            // used in debug
-    Game pickGame(BS::light_thread_pool &pool) const; // used in simulations
-    bool testCandidateGame(const Game &g,
-                           bool strongCheck) const; // used in debug
-    bool testCandidateGame(const Game &g, BS::light_thread_pool &pool,
-                           bool strongCheck) const; // used in simulations
+    void initializeFeasibilityCache();
+    void initializePortfolioStats();
 
-    virtual void updateDrawState(const Game &g, bool revert = false);
-    virtual bool validRemainingGame(const Game &g) const;
-    virtual bool verifyDrawHomeAway(std::unordered_map<int, TeamVerifier> &m,
-                                    int homeTeamIndex, int awayTeamIndex) const;
+    int numGamesAgainstCountry(int teamIndex, int country,
+                               const DFSContext &context) const;
 
-    // dfs methods (operate on context independent from obj state)
-    DFSContext createDFSContext() const;
-    bool dfs(const Game &g, const std::vector<Game> &remainingGames,
-             DFSContext &context, int sortMode, bool strongCheck,
-             std::atomic<bool> &stop) const;
-    void dfsSortRemainingGames(std::vector<Game> &remainingGames,
-                               const DFSContext &context, int sortMode) const;
-    virtual void dfsUpdateDrawState(const Game &g, DFSContext &context,
-                                    bool revert = false) const;
-    virtual bool dfsValidRemainingGame(const Game &g,
-                                       const DFSContext &context) const;
-    virtual bool dfsHomeTeamPredicate(int homeTeamIndex, int awayPot,
-                                      const DFSContext &context) const;
-    virtual bool dfsWeakCheck(const Game &g, const DFSContext &context) const;
-    virtual bool dfsStrongCheck(const DFSContext &context) const;
+    virtual bool verifyDrawHomeAway(std::unordered_map<int, TeamVerifier> &m,
+                                    int homeTeamIndex,
+                                    int awayTeamIndex) const = 0;
 
     // config
     int numPots;
@@ -67,77 +241,184 @@ class Draw {
     int numTeams;
     int numGamesPerPotPair;
     bool suppress;
-    std::vector<Team> teams; // all Teams in draw
-    std::mt19937 randomEngine;
-    std::unordered_map<std::string, int>
-        numTeamsByCountry; // country -> # teams
-    std::unordered_map<std::string, std::vector<int>>
-        teamIndsByCountry; // country -> team inds
+    std::shared_ptr<const DrawScenario> scenario;
+    const std::vector<Team> &teams; // scenario fields (see DrawScenario)
+    const std::vector<std::string> &countries;
+    const std::vector<int> &teamCountryIds;
+    const std::vector<int> &numTeamsByCountry;
+    const std::vector<std::vector<int>> &teamIndsByCountry;
+    const std::vector<uint64_t> &teamsByPot;
+    const std::vector<uint64_t> &teamsByCountry;
+    const std::vector<uint64_t> &legalOppsByTeamInd;
+    uint64_t randomKey;        // random by default
+    uint64_t randomStream = 0;
+    PhiloxEngine randomEngine; // in simulations, reseeded before each pick
+                               // (substream = # picked games)
+    bool creditPicks = false;
+    std::vector<double> pickCredits; // if creditPicks (see getPickCredits)
 
     // current draw state
-    std::vector<Game> allGames; // remaining potential Games
-    std::vector<Game> pickedGames;
     std::unordered_map<int, std::vector<Game>>
         gamesByTeamInd;                    // team ind -> picked Games
     std::unordered_set<int> drawnTeamInds; // team inds drawn so far
-    std::unordered_map<std::string, int>
-        numGamesByPotPair; // {home pot}:{away pot} -> # picked games
-    std::unordered_map<int, int>
-        numHomeGamesByTeamInd; // team ind -> # picked home games
-    std::unordered_map<int, int>
-        numAwayGamesByTeamInd; // team ind -> # picked away games
-    std::unordered_map<std::string, int>
-        numGamesByTeamIndOppCountry; // {team ind}:{opp country} -> count
-    std::unordered_map<std::string, bool>
-        isPickedByTeamIndOppPotLocation; // {team ind}:{opp pot}:{h/a}
-    std::unordered_set<std::string>
-        pickedGamesTeamInds; // {home team ind}:{away team ind} per picked game
-
-    std::vector<std::unordered_set<int>>
-        needsHomeAgainstPot; // pot ind (0-based) -> set of team inds with
-                             // unscheduled home games against this pot
-    std::vector<std::unordered_set<int>>
-        needsAwayAgainstPot; // pot ind (0-based) -> set of team inds with
-                             // unscheduled away games against this pot
-    std::unordered_map<std::string,
-                       int>
-        countryHomeNeeds; // {country}:{pot} -> global count of country's teams
-                          // that need home game against pot
-    std::unordered_map<std::string,
-                       int>
-        countryAwayNeeds; // {country}:{pot} -> global count of country's teams
-                          // that need away game against pot
+    std::vector<Game> pickedGames;         // picked Games, in pick order
+    DFSContext state;                      // constraint counters
+    FeasibilityCache *feasibilityCache =
+        nullptr; // verdicts proven by DFS so far, shared by all candidate
+                 // tests and DFS workers of this draw (owned by this draw
+                 // unless set by setFeasibilityCache)
+    std::unique_ptr<FeasibilityCache> ownedFeasibilityCache;
+    PortfolioStats *portfolioStats =
+        nullptr; // ordering win rates, which pick the orderings of each
+                 // candidate test (owned by this draw unless set by
+                 // setPortfolioStats)
+    std::unique_ptr<PortfolioStats> ownedPortfolioStats;
+    DFSBudget dfsBudget; // node budgets of each candidate game test
+};
+
+// Draw specialized for a DrawFormat: loop bounds are compile-time constants
+// and nothing called from dfs is virtual
+template <typename Format> class DrawEngine : public Draw {
+  public:
+    bool draw() override;
+    bool draw(Scheduler &scheduler) override;
+    void reset(const std::vector<Game> &initialGames) override;
+
+    static std::shared_ptr<const DrawScenario> createScenario(
+        const std::vector<Team> &t,
+        const std::unordered_set<std::string> &bannedCountryMatchups);
+
+  protected:
+    static constexpr int POTS = Format::POTS;
+    static constexpr int TEAMS_PER_POT = Format::TEAMS_PER_POT;
+    static constexpr int GAMES_PER_TEAM = Format::GAMES_PER_TEAM;
+    static constexpr int GAMES_PER_POT_PAIR = Format::GAMES_PER_POT_PAIR;
+    static constexpr int TEAMS = POTS * TEAMS_PER_POT;
+    using PotPolicy = typename Format::PotPolicy;
+    static_assert(POTS <= MAX_POTS && TEAMS <= MAX_TEAMS &&
+                      TEAMS * GAMES_PER_TEAM / 2 <= MAX_GAMES,
+                  "draw format exceeds DFSContext bounds");
+    static constexpr uint64_t DFS_POLL_NODES =
+        1024; // # DFS nodes between dfsPoll calls
+
+    DrawEngine(std::shared_ptr<const DrawScenario> sc,
+               const std::vector<Game> &initialGames, bool suppress);
+    DrawEngine(const std::vector<Team> &t,
+               const std::vector<Game> &initialGames,
+               const std::unordered_set<std::string> &bannedCountryMatchups,
+               bool suppress);
+    DrawEngine(std::string teamsPath, std::string initialGamesPath,
+               std::string bannedCountryMatchupsPath, bool suppress);
+
+    int pickTeamIndex(int pot);
+    Game pickGame(
+        const std::vector<Game> &remainingGames) const; // used in debug
+    Game pickGame(const std::vector<Game> &remainingGames, Scheduler &scheduler,
+                  std::vector<Game> *feasibleGames =
+                      nullptr) const; // used in simulations; optionally
+                                      // also finds every feasible game of
+                                      // the picked game's pot pair
+    bool testCandidateGame(const Game &g,
+                           bool strongCheck) const; // used in debug
+    bool testCandidateGame(const Game &g, Scheduler &scheduler,
+                           bool strongCheck,
+                           std::vector<Game> *witness =
+                               nullptr) const; // used in simulations
+    template <typename RunPortfolio>
+    bool dfsRestarts(RunPortfolio runPortfolio) const;
+    int runPortfolio(const Game &g, bool strongCheck, const DFSBudget &budget,
+                     uint64_t salt,
+                     std::chrono::steady_clock::time_point deadline)
+        const; // used in debug
+    int runPortfolio(const Game &g, Scheduler &scheduler, bool strongCheck,
+                     const DFSBudget &budget, uint64_t salt,
+                     std::chrono::steady_clock::time_point deadline,
+                     std::vector<Game> *witness) const; // used in simulations
+
+    void updateDrawState(const Game &g);
+    bool verifyDrawHomeAway(std::unordered_map<int, TeamVerifier> &m,
+                            int homeTeamIndex,
+                            int awayTeamIndex) const override;
+
+    // dfs methods (operate on context independent from obj state)
+    DFSContext createDFSContext() const;
+    void dfsSearch(DFSPortfolio &portfolio, int slot) const;
+    static void runPortfolioSearch(void *arg);
+    void dfsSubtreeSearch(DFSSubtree &subtree) const;
+    static void runSubtreeSearch(void *arg);
+    bool dfsRun(const Game &g, DFSSearch &search) const;
+    void dfsPoll(DFSSearch &search) const;
+    void dfsSplit(DFSSearch &search) const;
+    void dfsRecordWitness(const Game &g, const DFSSearch &search) const;
+    bool dfs(const Game &g, DFSSearch &search) const;
+    void dfsSortRemainingGames(Game *first, Game *last,
+                               const DFSContext &context, int ordering,
+                               uint64_t salt) const;
+    void dfsUpdateDrawState(const Game &g, DFSContext &context,
+                            DFSTrail &trail) const;
+    void dfsUpdateLegalMasks(const Game &g, DFSContext &context,
+                             DFSTrail &trail) const;
+    void dfsRefreshLegalMasks(DFSContext &context) const;
+    void dfsRefreshLegalMasks(int teamIndex, DFSContext &context,
+                              DFSTrail &trail) const;
+    uint64_t dfsLegalOpps(int teamIndex, int location,
+                          const DFSContext &context) const;
+    std::vector<Game> remainingGames(const DFSContext &context) const;
+    int numRemainingGames(const DFSContext &context) const;
+    bool dfsValidRemainingGame(const Game &g, const DFSContext &context) const;
+    bool dfsHomeTeamPredicate(int homeTeamIndex, int awayPot,
+                              const DFSContext &context) const;
+    bool dfsWeakCheck(const Game &g, const DFSContext &context) const;
+    bool dfsFlowCheck(DFSContext &context, DFSTrail &trail) const;
+    bool dfsRepairFlow(int pot, int location, DFSContext &context,
+                       DFSTrail &trail) const;
+    bool dfsAugmentFlow(uint64_t lefts, uint64_t rights, int location,
+                        std::array<uint64_t, MAX_TEAMS> &flows,
+                        const DFSContext &context) const;
+    uint64_t dfsFlowOpps(int teamIndex, int location,
+                         const DFSContext &context) const;
+    int dfsFlowCapacity(int teamIndex, int location,
+                        const DFSContext &context) const;
+    uint64_t teamsInPots(uint8_t pots) const;
 };
 
-class UCLDraw : public Draw {
+class UCLDraw : public DrawEngine<UCLFormat> {
   public:
     UCLDraw(std::string teamsPath, std::string initialGamesPath = "",
             std::string bannedCountryMatchupsPath = "", bool suppress = true)
-        : Draw(teamsPath, initialGamesPath, bannedCountryMatchupsPath, 4, 9, 8,
-               9, suppress) {}
+        : DrawEngine(teamsPath, initialGamesPath, bannedCountryMatchupsPath,
+                     suppress) {}
     UCLDraw(const std::vector<Team> &t,
             const std::vector<Game> &g = std::vector<Game>(),
             const std::unordered_set<std::string> &bc =
                 std::unordered_set<std::string>(),
             bool suppress = true)
-        : Draw(t, g, bc, 4, 9, 8, 9, suppress) {}
+        : DrawEngine(t, g, bc, suppress) {}
+    UCLDraw(std::shared_ptr<const DrawScenario> sc,
+            const std::vector<Game> &g = std::vector<Game>(),
+            bool suppress = true)
+        : DrawEngine(sc, g, suppress) {}
 };
 
-class UELDraw : public Draw {
+class UELDraw : public DrawEngine<UELFormat> {
   public:
     UELDraw(std::string teamsPath, std::string initialGamesPath = "",
             std::string bannedCountryMatchupsPath = "", bool suppress = true)
-        : Draw(teamsPath, initialGamesPath, bannedCountryMatchupsPath, 4, 9, 8,
-               9, suppress) {}
+        : DrawEngine(teamsPath, initialGamesPath, bannedCountryMatchupsPath,
+                     suppress) {}
     UELDraw(const std::vector<Team> &t,
             const std::vector<Game> &g = std::vector<Game>(),
             const std::unordered_set<std::string> &bc =
                 std::unordered_set<std::string>(),
             bool suppress = true)
-        : Draw(t, g, bc, 4, 9, 8, 9, suppress) {}
+        : DrawEngine(t, g, bc, suppress) {}
+    UELDraw(std::shared_ptr<const DrawScenario> sc,
+            const std::vector<Game> &g = std::vector<Game>(),
+            bool suppress = true)
+        : DrawEngine(sc, g, suppress) {}
 };
 
-class UECLDraw : public Draw {
+class UECLDraw : public DrawEngine<UECLFormat> {
   public:
     UECLDraw(std::string teamsPath, std::string initialGamesPath = "",
              std::string bannedCountryMatchupsPath = "", bool suppress = true);
@@ -146,24 +427,14 @@ class UECLDraw : public Draw {
              const std::unordered_set<std::string> &bc =
                  std::unordered_set<std::string>(),
              bool suppress = true);
-
-  protected:
-    virtual void updateDrawState(const Game &g, bool revert = false);
-    virtual bool validRemainingGame(const Game &g) const;
-    virtual bool verifyDrawHomeAway(std::unordered_map<int, TeamVerifier> &m,
-                                    int homeTeamIndex, int awayTeamIndex) const;
-
-    // multithread versions
-    virtual void dfsUpdateDrawState(const Game &g, DFSContext &context,
-                                    bool revert = false) const;
-    virtual bool dfsValidRemainingGame(const Game &g,
-                                       const DFSContext &context) const;
-    virtual bool dfsHomeTeamPredicate(int homeTeamIndex, int awayPot,
-                                      const DFSContext &context) const;
-    virtual bool dfsWeakCheck(const Game &g, const DFSContext &context) const;
-    virtual bool dfsStrongCheck(const DFSContext &context) const;
+    UECLDraw(std::shared_ptr<const DrawScenario> sc,
+             const std::vector<Game> &g = std::vector<Game>(),
+             bool suppress = true);
 };
 
+extern template class DrawEngine<UCLFormat>;
+extern template class DrawEngine<UECLFormat>;
+
 class TimeoutException : public std::exception {
   public:
     virtual const char *what() const throw() {
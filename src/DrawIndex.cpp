@@ -0,0 +1,189 @@
+#include "DrawIndex.h"
+#include "CountMatrix.h"
+#include "DrawLog.h"
+#include "Results.h"
+#include "globals.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define DRAW_INDEX_X86
+#endif
+
+namespace {
+
+// # set bits of a[w] & b[w] over words (a == b counts a)
+size_t popcountAndPortable(const uint64_t *__restrict a,
+                           const uint64_t *__restrict b, size_t words) {
+    size_t n = 0;
+    for (size_t w = 0; w < words; w++) {
+        n += __builtin_popcountll(a[w] & b[w]);
+    }
+    return n;
+}
+
+#ifdef DRAW_INDEX_X86
+// the build targets baseline x86-64, which has no popcnt instruction (the
+// portable loop calls __popcountdi2), so faster versions are compiled for
+// their own targets and picked at startup
+
+// same loop, with the popcnt instruction
+__attribute__((target("popcnt"))) size_t
+popcountAndPopcnt(const uint64_t *__restrict a, const uint64_t *__restrict b,
+                  size_t words) {
+    size_t n = 0;
+    for (size_t w = 0; w < words; w++) {
+        n += _mm_popcnt_u64(a[w] & b[w]);
+    }
+    return n;
+}
+
+// 4 words at a time: per-nibble counts from a shuffle lookup, summed into
+// 64-bit lanes with sad against 0 (AVX2 has no vector popcount)
+__attribute__((target("avx2,popcnt"))) size_t
+popcountAndAVX2(const uint64_t *__restrict a, const uint64_t *__restrict b,
+                size_t words) {
+    const __m256i lookup =
+        _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+                         1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+    __m256i totals = _mm256_setzero_si256();
+    size_t w = 0;
+    for (; w + 4 <= words; w += 4) {
+        __m256i v = _mm256_and_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + w)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + w)));
+        __m256i counts = _mm256_add_epi8(
+            _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, lowNibbles)),
+            _mm256_shuffle_epi8(
+                lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibbles)));
+        totals = _mm256_add_epi64(
+            totals, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+    }
+    size_t n = _mm256_extract_epi64(totals, 0) +
+               _mm256_extract_epi64(totals, 1) +
+               _mm256_extract_epi64(totals, 2) +
+               _mm256_extract_epi64(totals, 3);
+    for (; w < words; w++) {
+        n += _mm_popcnt_u64(a[w] & b[w]);
+    }
+    return n;
+}
+#endif
+
+using PopcountAnd = size_t (*)(const uint64_t *, const uint64_t *, size_t);
+
+PopcountAnd selectPopcountAnd() {
+#ifdef DRAW_INDEX_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return popcountAndAVX2;
+    }
+    if (__builtin_cpu_supports("popcnt")) {
+        return popcountAndPopcnt;
+    }
+#endif
+    return popcountAndPortable;
+}
+
+// best version this CPU supports
+const PopcountAnd popcountAnd = selectPopcountAnd();
+
+} // namespace
+
+DrawIndex::DrawIndex(const MappedResults &log)
+    : teams(log.header().numTeams) {
+    uint64_t bytes = 0;
+    const uint64_t *records =
+        static_cast<const uint64_t *>(log.section(DRAW_LOG_SECTION, &bytes));
+    if (!records) {
+        std::cerr << "DrawIndex() error: file has no draw log" << std::endl;
+        exit(1);
+    }
+    const int recordWords = drawLogRecordWords(teams);
+    const int cells = teams * teams;
+    draws = bytes / (recordWords * sizeof(uint64_t));
+    words = (draws + 63) / 64;
+
+    // only games some draw has get a bitmap
+    std::vector<uint64_t> seen(recordWords - 1, 0);
+    for (size_t r = 0; r < draws; r++) {
+        const uint64_t *games = records + r * recordWords + 1;
+        for (int w = 0; w < recordWords - 1; w++) {
+            seen[w] |= games[w];
+        }
+    }
+    bitmapInds.assign(cells, -1);
+    int numBitmaps = 0;
+    for (int cell = 0; cell < cells; cell++) {
+        if ((seen[cell / 64] >> (cell % 64)) & 1) {
+            bitmapInds[cell] = numBitmaps++;
+        }
+    }
+
+    // transpose records (draw -> games) into bitmaps (game -> draws)
+    bitmaps.assign(static_cast<size_t>(numBitmaps) * words, 0);
+    for (size_t r = 0; r < draws; r++) {
+        const uint64_t *games = records + r * recordWords + 1;
+        const uint64_t bit = uint64_t{1} << (r % 64);
+        for (int w = 0; w < recordWords - 1; w++) {
+            for (uint64_t m = games[w]; m; m &= m - 1) {
+                int cell = w * 64 + __builtin_ctzll(m);
+                bitmaps[bitmapInds[cell] * words + r / 64] |= bit;
+            }
+        }
+    }
+}
+
+int DrawIndex::numTeams() const { return teams; }
+
+size_t DrawIndex::numDraws() const { return draws; }
+
+std::vector<uint64_t> DrawIndex::select(const std::vector<Game> &games) const {
+    // all draws (bits past the last draw stay clear)
+    std::vector<uint64_t> selection(words, ~uint64_t{0});
+    if (draws % 64) {
+        selection.back() = (uint64_t{1} << (draws % 64)) - 1;
+    }
+    for (const Game &g : games) {
+        const uint64_t *b = bitmap(g.h, g.a);
+        if (!b) {
+            std::fill(selection.begin(), selection.end(), 0);
+            break;
+        }
+        uint64_t *__restrict s = selection.data();
+        for (size_t w = 0; w < words; w++) {
+            s[w] &= b[w];
+        }
+    }
+    return selection;
+}
+
+size_t DrawIndex::count(const std::vector<uint64_t> &selection) {
+    return popcountAnd(selection.data(), selection.data(), selection.size());
+}
+
+CountMatrix
+DrawIndex::countGames(const std::vector<uint64_t> &selection) const {
+    CountMatrix counts(teams);
+    const uint64_t *__restrict s = selection.data();
+    for (int h = 0; h < teams; h++) {
+        for (int a = 0; a < teams; a++) {
+            const uint64_t *__restrict b = bitmap(h, a);
+            if (!b) {
+                continue;
+            }
+            counts.add(0, h, a, static_cast<int>(popcountAnd(s, b, words)));
+        }
+    }
+    return counts;
+}
+
+const uint64_t *DrawIndex::bitmap(int h, int a) const {
+    int ind = bitmapInds[h * teams + a];
+    return ind < 0 ? nullptr : &bitmaps[ind * words];
+}
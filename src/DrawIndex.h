@@ -0,0 +1,41 @@
+#ifndef DRAW_INDEX_H
+#define DRAW_INDEX_H
+
+#include "CountMatrix.h"
+#include "Results.h"
+#include "globals.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// per-game bitmap index over a draw log (see DrawLog.h), for conditional
+// matchup probabilities
+// - bit r of game h-a's bitmap is set iff the log's r-th draw has game h-a
+// - conditioning on games ANDs their bitmaps into a selection of draws;
+//   counting games within a selection is an AND + popcount per word (AVX2 or
+//   popcnt versions, picked at startup, if the CPU has them)
+// - games that no draw has (e.g. same country) get no bitmap
+class DrawIndex {
+  public:
+    explicit DrawIndex(const MappedResults &log);
+
+    int numTeams() const;
+    size_t numDraws() const;
+
+    // draws that have all of the given games
+    std::vector<uint64_t> select(const std::vector<Game> &games) const;
+    static size_t count(const std::vector<uint64_t> &selection);
+    // # draws of the selection with each game, as a single slice matrix
+    CountMatrix countGames(const std::vector<uint64_t> &selection) const;
+
+  private:
+    const uint64_t *bitmap(int h, int a) const; // nullptr if no draw has h-a
+
+    int teams;
+    size_t draws;
+    size_t words; // per bitmap
+    std::vector<int> bitmapInds; // h * teams + a -> bitmap ind (-1 if none)
+    std::vector<uint64_t> bitmaps;
+};
+
+#endif // DRAW_INDEX_H
@@ -0,0 +1,163 @@
+#include "DrawLog.h"
+#include "Results.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+int drawLogRecordWords(int numTeams) {
+    return 1 + (numTeams * numTeams + 63) / 64;
+}
+
+DrawLogWriter::DrawLogWriter(const std::filesystem::path &path,
+                             const ResultsHeader &header, int numTeams,
+                             int numWorkers)
+    : teams(numTeams), recordWords(drawLogRecordWords(numTeams)) {
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "DrawLogWriter() error: cannot open " << path.string()
+                  << std::endl;
+        exit(1);
+    }
+    // section size is filled in by close()
+    fileHeader = makeResultsFileHeader(header, numTeams, 1);
+    ResultsSectionHeader sh{DRAW_LOG_SECTION, 0, 0};
+    if (write(fd, &fileHeader, sizeof(fileHeader)) != sizeof(fileHeader) ||
+        write(fd, &sh, sizeof(sh)) != sizeof(sh)) {
+        std::cerr << "DrawLogWriter() error: cannot write " << path.string()
+                  << std::endl;
+        exit(1);
+    }
+    for (int w = 0; w < numWorkers; w++) {
+        rings.push_back(std::make_unique<Ring>());
+        rings.back()->records =
+            std::make_unique<uint64_t[]>(RING_RECORDS * recordWords);
+    }
+    writer = std::thread(&DrawLogWriter::writerLoop, this);
+}
+
+DrawLogWriter::~DrawLogWriter() { close(); }
+
+void DrawLogWriter::setIterations(int iterations) {
+    fileHeader.iterations = iterations;
+}
+
+void DrawLogWriter::add(int worker, int drawIndex,
+                        const std::vector<Game> &games) {
+    Ring &ring = *rings[worker];
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    while (head - ring.tail.load(std::memory_order_acquire) == RING_RECORDS) {
+        std::this_thread::yield();
+    }
+    uint64_t *record = &ring.records[(head % RING_RECORDS) * recordWords];
+    std::fill(record, record + recordWords, 0);
+    record[0] = drawIndex;
+    for (const Game &g : games) {
+        int bit = g.h * teams + g.a;
+        record[1 + bit / 64] |= uint64_t{1} << (bit % 64);
+    }
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void DrawLogWriter::close() {
+    if (!writer.joinable()) {
+        return;
+    }
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+    // pad section to 16 bytes, then fill in its size (and the file header,
+    // in case iterations changed)
+    const uint64_t bytes = records * recordWords * sizeof(uint64_t);
+    const char padding[16] = {};
+    ResultsSectionHeader sh{DRAW_LOG_SECTION, 0, bytes};
+    if (write(fd, padding, (16 - bytes % 16) % 16) < 0 ||
+        pwrite(fd, &fileHeader, sizeof(fileHeader), 0) !=
+            sizeof(fileHeader) ||
+        pwrite(fd, &sh, sizeof(sh), sizeof(ResultsFileHeader)) !=
+            sizeof(sh)) {
+        std::cerr << "DrawLogWriter::close() error: cannot write draw log"
+                  << std::endl;
+        exit(1);
+    }
+    ::close(fd);
+}
+
+uint64_t DrawLogWriter::numRecords() const { return records; }
+
+void DrawLogWriter::writerLoop() {
+    while (true) {
+        // read before flushing, so no record added before stopping is missed
+        bool stop = stopping.load(std::memory_order_acquire);
+        if (!flush()) {
+            if (stop) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+bool DrawLogWriter::flush() {
+    const size_t recordBytes = recordWords * sizeof(uint64_t);
+    // filled parts of all rings: up to 2 spans each (ring wraps around)
+    std::vector<iovec> spans;
+    std::vector<uint64_t> heads(rings.size());
+    uint64_t numAdded = 0;
+    for (size_t w = 0; w < rings.size(); w++) {
+        Ring &ring = *rings[w];
+        const uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        heads[w] = ring.head.load(std::memory_order_acquire);
+        uint64_t first = tail % RING_RECORDS;
+        uint64_t n = heads[w] - tail;
+        while (n > 0) {
+            uint64_t len = std::min<uint64_t>(n, RING_RECORDS - first);
+            spans.push_back(
+                {&ring.records[first * recordWords], len * recordBytes});
+            n -= len;
+            first = 0;
+        }
+        numAdded += heads[w] - tail;
+    }
+    if (!numAdded) {
+        return false;
+    }
+    // writev may write less than asked, and takes at most IOV_MAX spans
+    size_t next = 0;
+    while (next < spans.size()) {
+        int count = static_cast<int>(
+            std::min<size_t>(spans.size() - next, IOV_MAX));
+        ssize_t n = writev(fd, &spans[next], count);
+        if (n < 0) {
+            std::cerr << "DrawLogWriter::flush() error: cannot write draw log"
+                      << std::endl;
+            exit(1);
+        }
+        size_t left = n;
+        while (next < spans.size() && left >= spans[next].iov_len) {
+            left -= spans[next++].iov_len;
+        }
+        if (left > 0) {
+            spans[next].iov_base = static_cast<char *>(spans[next].iov_base) +
+                                   left;
+            spans[next].iov_len -= left;
+        }
+    }
+    // hand written slots back to workers
+    for (size_t w = 0; w < rings.size(); w++) {
+        rings[w]->tail.store(heads[w], std::memory_order_release);
+    }
+    records += numAdded;
+    return true;
+}
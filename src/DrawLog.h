@@ -0,0 +1,66 @@
+#ifndef DRAW_LOG_H
+#define DRAW_LOG_H
+
+#include "Results.h"
+#include "globals.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// per-draw log: a binary results file (see Results.h) whose DRAW_LOG_SECTION
+// holds one record per simulated draw, in the order draws completed
+// - a record is drawLogRecordWords(numTeams) uint64 words: word 0 is the
+//   draw's index in the run, and bit h * numTeams + a of words 1.. is set iff
+//   the draw has game h-a (21 words of games for 36 teams)
+int drawLogRecordWords(int numTeams);
+
+// streams records to a draw log from a dedicated writer thread
+// - each worker adds records to its own single-producer single-consumer ring
+//   (lock-free; a worker only waits if its ring is full)
+// - the writer thread passes the filled parts of all rings straight to
+//   writev(), without copying them
+class DrawLogWriter {
+  public:
+    DrawLogWriter(const std::filesystem::path &path,
+                  const ResultsHeader &header, int numTeams, int numWorkers);
+    ~DrawLogWriter();
+    DrawLogWriter(const DrawLogWriter &) = delete;
+    DrawLogWriter &operator=(const DrawLogWriter &) = delete;
+
+    // from worker `worker` only
+    void add(int worker, int drawIndex, const std::vector<Game> &games);
+    // # draws of the run, if not known when the log was opened (e.g. of an
+    // adaptive run); written to the file header by close()
+    void setIterations(int iterations);
+    // write remaining records and finish the file (after the last add())
+    void close();
+
+    uint64_t numRecords() const;
+
+  private:
+    static constexpr size_t RING_RECORDS = 256;
+
+    struct alignas(64) Ring {
+        std::unique_ptr<uint64_t[]> records; // RING_RECORDS records
+        alignas(64) std::atomic<uint64_t> head{0}; // # added, by worker
+        alignas(64) std::atomic<uint64_t> tail{0}; // # written, by writer
+    };
+
+    void writerLoop();
+    bool flush(); // write all added records; returns false if there were none
+
+    int teams;
+    int recordWords;
+    int fd;
+    ResultsFileHeader fileHeader;
+    uint64_t records = 0; // # written (writer thread only, until joined)
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::atomic<bool> stopping{false};
+    std::thread writer;
+};
+
+#endif // DRAW_LOG_H
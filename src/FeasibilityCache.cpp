@@ -0,0 +1,113 @@
+#include "FeasibilityCache.h"
+#include "globals.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+uint64_t gameHash(const Game &g) {
+    // splitmix64 finalizer of the game's index, so keys are identical across
+    // Draw objects
+    uint64_t z = static_cast<uint64_t>(g.h * MAX_TEAMS + g.a + 1) *
+                 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+FeasibilityCache::FeasibilityCache(int capacityLog2)
+    : capacity(size_t{1} << capacityLog2),
+      bucketMask(capacity / SLOTS_PER_BUCKET - 1),
+      slots(new std::atomic<uint64_t>[capacity]) {
+    for (size_t i = 0; i < capacity; i++) {
+        slots[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+FeasibilityCache::Verdict FeasibilityCache::lookup(uint64_t hash) const {
+    uint64_t key = hash & ~VERDICT_MASK;
+    if (key == 0) {
+        return UNKNOWN; // 0 marks empty slots
+    }
+    StatsShard &shard = statsShard();
+    shard.lookups.fetch_add(1, std::memory_order_relaxed);
+    const std::atomic<uint64_t> *bucket =
+        &slots[(hash & bucketMask) * SLOTS_PER_BUCKET];
+    for (int i = 0; i < SLOTS_PER_BUCKET; i++) {
+        uint64_t slot = bucket[i].load(std::memory_order_relaxed);
+        if ((slot & ~VERDICT_MASK) == key) {
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            return static_cast<Verdict>(slot & VERDICT_MASK);
+        }
+    }
+    return UNKNOWN;
+}
+
+void FeasibilityCache::record(uint64_t hash, Verdict verdict) {
+    uint64_t key = hash & ~VERDICT_MASK;
+    if (key == 0) {
+        return; // 0 marks empty slots
+    }
+    std::atomic<uint64_t> *bucket =
+        &slots[(hash & bucketMask) * SLOTS_PER_BUCKET];
+    for (int i = 0; i < SLOTS_PER_BUCKET; i++) {
+        uint64_t slot = bucket[i].load(std::memory_order_relaxed);
+        if ((slot & ~VERDICT_MASK) == key) {
+            return; // verdicts are proven, so an existing one is identical
+        }
+        if (slot == 0 && bucket[i].compare_exchange_strong(
+                             slot, key | verdict, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+    // bucket full: evict a slot chosen by the hash's high bits
+    bucket[(hash >> 60) % SLOTS_PER_BUCKET].store(key | verdict,
+                                                  std::memory_order_relaxed);
+    statsShard().evictions.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t FeasibilityCache::memoryBytes() const {
+    return capacity * sizeof(std::atomic<uint64_t>);
+}
+
+size_t FeasibilityCache::numEntries() const {
+    size_t count = 0;
+    for (size_t i = 0; i < capacity; i++) {
+        if (slots[i].load(std::memory_order_relaxed) != 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+uint64_t FeasibilityCache::numLookups() const {
+    uint64_t total = 0;
+    for (const StatsShard &shard : stats) {
+        total += shard.lookups.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t FeasibilityCache::numHits() const {
+    uint64_t total = 0;
+    for (const StatsShard &shard : stats) {
+        total += shard.hits.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t FeasibilityCache::numEvictions() const {
+    uint64_t total = 0;
+    for (const StatsShard &shard : stats) {
+        total += shard.evictions.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+FeasibilityCache::StatsShard &FeasibilityCache::statsShard() const {
+    // each thread gets a fixed shard on first use
+    static std::atomic<int> nextShard{0};
+    thread_local int shard =
+        nextShard.fetch_add(1, std::memory_order_relaxed) % STATS_SHARDS;
+    return stats[shard];
+}
@@ -0,0 +1,56 @@
+#ifndef FEASIBILITY_CACHE_H
+#define FEASIBILITY_CACHE_H
+
+#include "globals.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Zobrist key of a picked game; a draw state's hash is the XOR of the keys of
+// its picked games, since every DFSContext counter is a function of that set
+uint64_t gameHash(const Game &g);
+
+// fixed-size, lock-free table of draw state hash -> proven DFS verdict,
+// shared by concurrent DFS workers (and, optionally, by all draws of a
+// Simulator run)
+// - each slot packs the hash (low 2 bits dropped) with the verdict
+// - a hash maps to a bucket of SLOTS_PER_BUCKET slots; when the bucket is
+//   full, one slot picked by the hash is evicted
+class FeasibilityCache {
+  public:
+    enum Verdict : uint8_t { UNKNOWN = 0, INFEASIBLE = 1, FEASIBLE = 2 };
+
+    explicit FeasibilityCache(int capacityLog2);
+    Verdict lookup(uint64_t hash) const;
+    void record(uint64_t hash, Verdict verdict);
+
+    // stats
+    size_t memoryBytes() const;
+    size_t numEntries() const; // scans table
+    uint64_t numLookups() const;
+    uint64_t numHits() const;
+    uint64_t numEvictions() const;
+
+  private:
+    static constexpr int SLOTS_PER_BUCKET = 4;
+    static constexpr uint64_t VERDICT_MASK = 3;
+    static constexpr int STATS_SHARDS = 64;
+
+    // stats counters are sharded by thread to keep DFS workers off each
+    // other's cache lines
+    struct alignas(64) StatsShard {
+        std::atomic<uint64_t> lookups{0};
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> evictions{0};
+    };
+    StatsShard &statsShard() const;
+
+    size_t capacity;   // # slots
+    size_t bucketMask; // # buckets - 1
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    mutable std::array<StatsShard, STATS_SHARDS> stats;
+};
+
+#endif // FEASIBILITY_CACHE_H
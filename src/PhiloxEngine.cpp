@@ -0,0 +1,47 @@
+#include "PhiloxEngine.h"
+#include <array>
+#include <cstdint>
+
+namespace {
+constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+constexpr uint32_t PHILOX_W0 = 0x9E3779B9; // golden ratio
+constexpr uint32_t PHILOX_W1 = 0xBB67AE85; // sqrt(3) - 1
+constexpr int PHILOX_ROUNDS = 10;
+} // namespace
+
+PhiloxEngine::PhiloxEngine(uint64_t k, uint64_t stream, uint32_t substream) {
+    seed(k, stream, substream);
+}
+
+void PhiloxEngine::seed(uint64_t k, uint64_t stream, uint32_t substream) {
+    key = {static_cast<uint32_t>(k), static_cast<uint32_t>(k >> 32)};
+    counter = {0, substream, static_cast<uint32_t>(stream),
+               static_cast<uint32_t>(stream >> 32)};
+    blockIndex = 4; // generate block 0 on first call
+}
+
+PhiloxEngine::result_type PhiloxEngine::operator()() {
+    if (blockIndex == 4) {
+        generateBlock();
+        counter[0]++;
+        blockIndex = 0;
+    }
+    return block[blockIndex++];
+}
+
+void PhiloxEngine::generateBlock() {
+    std::array<uint32_t, 4> x = counter;
+    std::array<uint32_t, 2> k = key;
+    for (int round = 0; round < PHILOX_ROUNDS; round++) {
+        uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * x[0];
+        uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * x[2];
+        x = {static_cast<uint32_t>(p1 >> 32) ^ x[1] ^ k[0],
+             static_cast<uint32_t>(p1),
+             static_cast<uint32_t>(p0 >> 32) ^ x[3] ^ k[1],
+             static_cast<uint32_t>(p0)};
+        k[0] += PHILOX_W0;
+        k[1] += PHILOX_W1;
+    }
+    block = x;
+}
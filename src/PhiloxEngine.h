@@ -0,0 +1,37 @@
+#ifndef PHILOX_ENGINE_H
+#define PHILOX_ENGINE_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+// counter-based random bit generator (Philox4x32-10), usable with <random>
+// and std::shuffle
+// - output block n of stream (key, stream, substream) is a pure function of
+//   those values, so e.g. each simulated draw's numbers don't depend on which
+//   thread runs it or what ran before
+// - counter words: [0] block index, [1] substream, [2..3] stream
+class PhiloxEngine {
+  public:
+    using result_type = uint32_t;
+
+    explicit PhiloxEngine(uint64_t key = 0, uint64_t stream = 0,
+                          uint32_t substream = 0);
+    void seed(uint64_t key, uint64_t stream = 0, uint32_t substream = 0);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+    result_type operator()();
+
+  private:
+    void generateBlock();
+
+    std::array<uint32_t, 2> key;
+    std::array<uint32_t, 4> counter;
+    std::array<uint32_t, 4> block; // current output block
+    int blockIndex;                // next unused word of block
+};
+
+#endif // PHILOX_ENGINE_H
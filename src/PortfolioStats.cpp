@@ -0,0 +1,92 @@
+#include "PortfolioStats.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+const char *orderingName(int ordering) {
+    static const char *const NAMES[] = {
+        "big country first",        "small country first",
+        "most games left first",    "low country needs first",
+        "high country needs first", "fewest games left first",
+        "fewest options first",     "random ties",
+    };
+    return NAMES[ordering];
+}
+
+void PortfolioStats::choose(int *orderings, int n) const {
+    // slot 0 (which searches alone first) exploits: best win rate so far;
+    // other slots explore with UCB1: win rate plus a bonus that shrinks with
+    // # trials
+    double logContested =
+        std::log(static_cast<double>(
+            std::max<uint64_t>(contested.load(std::memory_order_relaxed), 1)));
+    std::array<double, NUM_DFS_ORDERINGS> winRates;
+    std::array<double, NUM_DFS_ORDERINGS> scores;
+    for (int o = 0; o < NUM_DFS_ORDERINGS; o++) {
+        uint64_t trials = stats[o].trials.load(std::memory_order_relaxed);
+        uint64_t wins = stats[o].wins.load(std::memory_order_relaxed);
+        winRates[o] = trials ? static_cast<double>(wins) / trials : -1;
+        scores[o] = trials ? winRates[o] + std::sqrt(2 * logContested / trials)
+                           : std::numeric_limits<double>::infinity();
+    }
+    // untried orderings never win slot 0, unless all are untried
+    winRates[BIG_COUNTRY_FIRST] = std::max(winRates[BIG_COUNTRY_FIRST], -0.5);
+    uint32_t chosen = 0;
+    for (int i = 0; i < n; i++) {
+        const std::array<double, NUM_DFS_ORDERINGS> &key =
+            i == 0 ? winRates : scores;
+        int best = -1; // ties -> lower ordering
+        for (int o = 0; o < NUM_DFS_ORDERINGS; o++) {
+            if (!((chosen >> o) & 1) && (best == -1 || key[o] > key[best])) {
+                best = o;
+            }
+        }
+        chosen |= 1u << best;
+        orderings[i] = best;
+    }
+}
+
+void PortfolioStats::record(const int *orderings, int n, bool isContested,
+                            int winnerSlot, uint64_t answerNodes) {
+    if (isContested) {
+        contested.fetch_add(1, std::memory_order_relaxed);
+        for (int i = 0; i < n; i++) {
+            stats[orderings[i]].trials.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (winnerSlot >= 0) {
+        OrderingStats &winner = stats[orderings[winnerSlot]];
+        if (isContested) {
+            winner.wins.fetch_add(1, std::memory_order_relaxed);
+        }
+        winner.answers.fetch_add(1, std::memory_order_relaxed);
+        winner.answerNodes.fetch_add(answerNodes, std::memory_order_relaxed);
+    }
+}
+
+uint64_t PortfolioStats::numContested() const {
+    return contested.load(std::memory_order_relaxed);
+}
+
+uint64_t PortfolioStats::numTrials(int ordering) const {
+    return stats[ordering].trials.load(std::memory_order_relaxed);
+}
+
+uint64_t PortfolioStats::numWins(int ordering) const {
+    return stats[ordering].wins.load(std::memory_order_relaxed);
+}
+
+uint64_t PortfolioStats::numAnswers(int ordering) const {
+    return stats[ordering].answers.load(std::memory_order_relaxed);
+}
+
+double PortfolioStats::meanAnswerNodes(int ordering) const {
+    uint64_t answers = numAnswers(ordering);
+    return answers ? static_cast<double>(stats[ordering].answerNodes.load(
+                         std::memory_order_relaxed)) /
+                         answers
+                   : 0;
+}
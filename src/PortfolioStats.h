@@ -0,0 +1,63 @@
+#ifndef PORTFOLIO_STATS_H
+#define PORTFOLIO_STATS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// candidate game orderings a DFSPortfolio can race (see
+// DrawEngine::dfsSortRemainingGames); each orders a frame's candidates by
+// their away team
+enum DFSOrdering : int {
+    BIG_COUNTRY_FIRST,       // country with most teams, then most games left
+    SMALL_COUNTRY_FIRST,     // country with least teams, then most games left
+    MOST_GAMES_LEFT_FIRST,   // most games left
+    LOW_COUNTRY_NEEDS_FIRST, // country with least away needs against home
+                             // pot, then least games left
+    HIGH_COUNTRY_NEEDS_FIRST, // country with most away needs against home
+                              // pot, then least games left
+    FEWEST_GAMES_LEFT_FIRST,  // least games left
+    FEWEST_OPTIONS_FIRST, // fewest legal hosts left in home pot (MRV), then
+                          // most games left
+    RANDOM_TIES, // BIG_COUNTRY_FIRST, ties broken by a hash of the state
+    NUM_DFS_ORDERINGS
+};
+
+const char *orderingName(int ordering);
+
+// win rates of DFS orderings over the portfolios of a run (or of a draw), used
+// to pick each portfolio's orderings with a bandit policy
+// - a portfolio is contested if its first search outlived its slice; each
+//   ordering it raced gets a trial, and the one that decided it a win
+// - uncontested portfolios only count as answers of their first ordering,
+//   since no other ordering ran
+class PortfolioStats {
+  public:
+    // fill orderings[0..n) with distinct orderings: the best by win rate
+    // (BIG_COUNTRY_FIRST until any has run in a contested portfolio), then the
+    // best by UCB1 score (untried orderings first, in DFSOrdering order)
+    void choose(int *orderings, int n) const;
+    // winnerSlot is -1 if the portfolio timed out
+    void record(const int *orderings, int n, bool contested, int winnerSlot,
+                uint64_t answerNodes);
+
+    // stats
+    uint64_t numContested() const;
+    uint64_t numTrials(int ordering) const;
+    uint64_t numWins(int ordering) const;
+    uint64_t numAnswers(int ordering) const; // contested or not
+    double meanAnswerNodes(int ordering) const;
+
+  private:
+    struct alignas(64) OrderingStats {
+        std::atomic<uint64_t> trials{0};
+        std::atomic<uint64_t> wins{0};
+        std::atomic<uint64_t> answers{0};
+        std::atomic<uint64_t> answerNodes{0}; // summed over answers
+    };
+
+    std::atomic<uint64_t> contested{0};
+    std::array<OrderingStats, NUM_DFS_ORDERINGS> stats;
+};
+
+#endif // PORTFOLIO_STATS_H
@@ -0,0 +1,377 @@
+#include "Results.h"
+#include "BatchMeans.h"
+#include "CountMatrix.h"
+#include "utils.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+int shardBegin(int iterations, int shard, int numShards) {
+    return static_cast<int>(int64_t{iterations} * shard / numShards);
+}
+
+void writeResults(const CountMatrix &counts, const ResultsHeader &header,
+                  const std::filesystem::path &outputPath,
+                  const BatchMeans *batchMeans,
+                  const std::vector<double> *expectedCounts) {
+    std::filesystem::create_directories(outputPath.parent_path());
+    std::ofstream out(outputPath);
+    // write frontmatter
+    out << "---\n";
+    out << "timestamp: "
+        << formatSystemTimePoint(header.timestamp, "%Y-%m-%d %H:%M:%S")
+        << "\n";
+    out << "competition: " << header.competition << "\n";
+    out << "year: " << header.year << "\n";
+    out << "simulations: " << header.iterations << "\n";
+    out << "seed: " << header.seed << "\n";
+    if (batchMeans) {
+        out << "batches: " << batchMeans->numBatches() << "\n";
+    }
+    if (expectedCounts) {
+        out << "estimator: rao-blackwell\n";
+    }
+    out << "---\n";
+    // write results
+    out << "t1,t2,home,away,total";
+    if (batchMeans) {
+        out << ",home_ci,away_ci,total_ci";
+    }
+    if (expectedCounts) {
+        out << ",home_rb,away_rb,total_rb";
+    }
+    out << "\n";
+    for (int i = 0; i < counts.numTeams() - 1; i++) {
+        for (int j = i + 1; j < counts.numTeams(); j++) {
+            int homeAwayCounts = counts.get(i, j);
+            int awayHomeCounts = counts.get(j, i);
+            out << i << "," << j << "," << homeAwayCounts << ","
+                << awayHomeCounts << "," << homeAwayCounts + awayHomeCounts;
+            if (batchMeans) {
+                out << "," << 100 * batchMeans->gameHalfWidth(i, j, CI_95_Z)
+                    << "," << 100 * batchMeans->gameHalfWidth(j, i, CI_95_Z)
+                    << "," << 100 * batchMeans->pairHalfWidth(i, j, CI_95_Z);
+            }
+            if (expectedCounts) {
+                const int n = counts.numTeams();
+                double homeAway = (*expectedCounts)[i * n + j];
+                double awayHome = (*expectedCounts)[j * n + i];
+                out << "," << homeAway << "," << awayHome << ","
+                    << homeAway + awayHome;
+            }
+            out << "\n";
+        }
+    }
+}
+
+ResultsFileHeader makeResultsFileHeader(const ResultsHeader &header,
+                                        int numTeams, uint32_t numSections) {
+    ResultsFileHeader fh{};
+    std::memcpy(fh.magic, RESULTS_MAGIC, sizeof(fh.magic));
+    fh.version = RESULTS_VERSION;
+    fh.numTeams = numTeams;
+    std::strncpy(fh.competition, header.competition.c_str(),
+                 sizeof(fh.competition) - 1);
+    fh.year = header.year;
+    fh.numSections = numSections;
+    fh.iterations = header.iterations;
+    fh.seed = header.seed;
+    fh.scenarioHash = header.scenarioHash;
+    fh.shard = header.shard;
+    fh.numShards = header.numShards;
+    fh.timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+                       header.timestamp.time_since_epoch())
+                       .count();
+    return fh;
+}
+
+ResultsHeader makeResultsHeader(const ResultsFileHeader &fh) {
+    ResultsHeader header;
+    header.competition = std::string(
+        fh.competition, strnlen(fh.competition, sizeof(fh.competition)));
+    header.year = fh.year;
+    header.iterations = static_cast<int>(fh.iterations);
+    header.seed = fh.seed;
+    header.timestamp = std::chrono::system_clock::time_point(
+        std::chrono::seconds(fh.timestamp));
+    header.scenarioHash = fh.scenarioHash;
+    header.shard = fh.shard;
+    header.numShards = fh.numShards;
+    return header;
+}
+
+namespace {
+
+struct SectionData {
+    uint32_t kind; // ResultsSectionKind
+    const void *data;
+    uint64_t bytes;
+};
+
+// write all of data to fd, retrying interrupted writes; returns false on error
+bool writeAll(int fd, const void *data, size_t bytes) {
+    const char *p = static_cast<const char *>(data);
+    while (bytes > 0) {
+        ssize_t n = write(fd, p, bytes);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return false;
+        }
+        p += n;
+        bytes -= n;
+    }
+    return true;
+}
+
+// with sync, the file's data is on disk once this returns (e.g. before it is
+// renamed over an older file)
+void writeBinaryFile(const std::filesystem::path &outputPath,
+                     const ResultsHeader &header, int numTeams,
+                     const std::vector<SectionData> &sections,
+                     bool sync = false) {
+    ResultsFileHeader fh =
+        makeResultsFileHeader(header, numTeams, sections.size());
+    std::filesystem::create_directories(outputPath.parent_path());
+    int fd = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0 && writeAll(fd, &fh, sizeof(fh));
+    for (const SectionData &section : sections) {
+        ResultsSectionHeader sh{section.kind, 0, section.bytes};
+        const char padding[16] = {};
+        ok = ok && writeAll(fd, &sh, sizeof(sh)) &&
+             writeAll(fd, section.data, section.bytes) &&
+             writeAll(fd, padding, (16 - section.bytes % 16) % 16);
+    }
+    ok = ok && (!sync || fsync(fd) == 0);
+    // close can report a failed write too
+    if (fd >= 0 && close(fd) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        std::cerr << "writeBinaryFile() error: cannot write "
+                  << outputPath.string() << std::endl;
+        exit(1);
+    }
+}
+
+std::vector<int32_t> denseCounts(const CountMatrix &counts) {
+    const int numTeams = counts.numTeams();
+    std::vector<int32_t> dense(static_cast<size_t>(numTeams) * numTeams);
+    for (int h = 0; h < numTeams; h++) {
+        for (int a = 0; a < numTeams; a++) {
+            dense[h * numTeams + a] = counts.get(h, a);
+        }
+    }
+    return dense;
+}
+
+} // namespace
+
+void writeBinaryResults(const PartialResults &results,
+                        const std::filesystem::path &outputPath) {
+    std::vector<int32_t> counts = denseCounts(results.counts);
+    writeBinaryFile(
+        outputPath, results.header, results.counts.numTeams(),
+        {{COUNTS_SECTION, counts.data(), counts.size() * sizeof(int32_t)}});
+}
+
+PartialResults readBinaryResults(const std::filesystem::path &path) {
+    MappedResults file(path);
+    const ResultsFileHeader &fh = file.header();
+    PartialResults results(fh.numTeams);
+    results.header = makeResultsHeader(fh);
+    const int32_t *counts = file.counts();
+    if (!counts) {
+        std::cerr << "readBinaryResults() error: " << path.string()
+                  << " has no counts section" << std::endl;
+        exit(1);
+    }
+    const int numTeams = fh.numTeams;
+    for (int h = 0; h < numTeams; h++) {
+        for (int a = 0; a < numTeams; a++) {
+            results.counts.add(0, h, a, counts[h * numTeams + a]);
+        }
+    }
+    return results;
+}
+
+MappedResults::MappedResults(const std::filesystem::path &path)
+    : data(nullptr), size(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::cerr << "MappedResults() error: cannot open " << path.string()
+                  << std::endl;
+        exit(1);
+    }
+    size = st.st_size;
+    if (size >= sizeof(ResultsFileHeader)) {
+        void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        data = p == MAP_FAILED ? nullptr : static_cast<unsigned char *>(p);
+    }
+    close(fd);
+    if (!data || std::memcmp(header().magic, RESULTS_MAGIC, 8) != 0) {
+        std::cerr << "MappedResults() error: " << path.string()
+                  << " is not a binary results file" << std::endl;
+        exit(1);
+    }
+    if (header().version != RESULTS_VERSION) {
+        std::cerr << "MappedResults() error: " << path.string()
+                  << " has unsupported version " << header().version
+                  << std::endl;
+        exit(1);
+    }
+    uint64_t bytes = 0;
+    if (section(COUNTS_SECTION, &bytes) &&
+        bytes != uint64_t{header().numTeams} * header().numTeams *
+                     sizeof(int32_t)) {
+        std::cerr << "MappedResults() error: " << path.string()
+                  << " has a malformed counts section" << std::endl;
+        exit(1);
+    }
+}
+
+MappedResults::~MappedResults() {
+    munmap(const_cast<unsigned char *>(data), size);
+}
+
+const ResultsFileHeader &MappedResults::header() const {
+    return *reinterpret_cast<const ResultsFileHeader *>(data);
+}
+
+const void *MappedResults::section(uint32_t kind, uint64_t *bytes) const {
+    size_t offset = sizeof(ResultsFileHeader);
+    for (uint32_t s = 0; s < header().numSections; s++) {
+        if (offset + sizeof(ResultsSectionHeader) > size) {
+            break;
+        }
+        const ResultsSectionHeader &sh =
+            *reinterpret_cast<const ResultsSectionHeader *>(data + offset);
+        offset += sizeof(ResultsSectionHeader);
+        if (sh.bytes > size - offset) {
+            break;
+        }
+        if (sh.kind == kind) {
+            if (bytes) {
+                *bytes = sh.bytes;
+            }
+            return data + offset;
+        }
+        offset += (sh.bytes + 15) / 16 * 16;
+    }
+    return nullptr;
+}
+
+const int32_t *MappedResults::counts() const {
+    return static_cast<const int32_t *>(section(COUNTS_SECTION));
+}
+
+PartialResults mergePartialResults(const std::vector<PartialResults> &shards) {
+    if (shards.empty()) {
+        std::cerr << "mergePartialResults() error: no shards" << std::endl;
+        exit(1);
+    }
+    const PartialResults &first = shards[0];
+    PartialResults merged(first.counts.numTeams());
+    merged.header = first.header;
+    merged.header.shard = 0;
+    merged.header.numShards = 1;
+    std::vector<bool> seen(first.header.numShards, false);
+    for (const PartialResults &p : shards) {
+        if (p.header.competition != first.header.competition ||
+            p.header.year != first.header.year ||
+            p.header.iterations != first.header.iterations ||
+            p.header.seed != first.header.seed ||
+            p.header.scenarioHash != first.header.scenarioHash ||
+            p.header.numShards != first.header.numShards ||
+            p.counts.numTeams() != first.counts.numTeams()) {
+            std::cerr << "mergePartialResults() error: shards come from "
+                         "different runs"
+                      << std::endl;
+            exit(1);
+        }
+        const int k = p.header.shard;
+        if (k < 0 || k >= p.header.numShards || seen[k]) {
+            std::cerr << "mergePartialResults() error: shard " << k << "/"
+                      << p.header.numShards << " is invalid or repeated"
+                      << std::endl;
+            exit(1);
+        }
+        seen[k] = true;
+        for (int h = 0; h < p.counts.numTeams(); h++) {
+            for (int a = 0; a < p.counts.numTeams(); a++) {
+                merged.counts.add(0, h, a, p.counts.get(h, a));
+            }
+        }
+    }
+    for (int k = 0; k < first.header.numShards; k++) {
+        if (!seen[k]) {
+            std::cerr << "mergePartialResults() error: missing shard " << k
+                      << "/" << first.header.numShards << std::endl;
+            exit(1);
+        }
+    }
+    return merged;
+}
+
+void writeCheckpoint(const Checkpoint &checkpoint,
+                     const std::filesystem::path &path) {
+    std::vector<int32_t> counts = denseCounts(checkpoint.results.counts);
+    std::vector<uint64_t> progress = {
+        static_cast<uint64_t>(checkpoint.failures)};
+    progress.insert(progress.end(), checkpoint.completed.begin(),
+                    checkpoint.completed.end());
+    // write (and sync) a temporary file, then rename it over the previous
+    // checkpoint, so a crash mid-write leaves the previous one intact
+    std::filesystem::path tmpPath = path;
+    tmpPath += ".tmp";
+    writeBinaryFile(
+        tmpPath, checkpoint.results.header,
+        checkpoint.results.counts.numTeams(),
+        {{COUNTS_SECTION, counts.data(), counts.size() * sizeof(int32_t)},
+         {CHECKPOINT_SECTION, progress.data(),
+          progress.size() * sizeof(uint64_t)}},
+        true);
+    std::filesystem::rename(tmpPath, path);
+    // sync the directory too, so the rename itself survives a crash
+    std::filesystem::path dir =
+        path.has_parent_path() ? path.parent_path() : ".";
+    int dirFd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+}
+
+Checkpoint readCheckpoint(const std::filesystem::path &path) {
+    Checkpoint checkpoint(readBinaryResults(path));
+    MappedResults file(path);
+    uint64_t bytes = 0;
+    const uint64_t *progress = static_cast<const uint64_t *>(
+        file.section(CHECKPOINT_SECTION, &bytes));
+    const ResultsHeader &header = checkpoint.results.header;
+    const int numDraws =
+        shardBegin(header.iterations, header.shard + 1, header.numShards) -
+        shardBegin(header.iterations, header.shard, header.numShards);
+    if (!progress ||
+        bytes != (1 + (numDraws + 63) / 64) * sizeof(uint64_t)) {
+        std::cerr << "readCheckpoint() error: " << path.string()
+                  << " is not a checkpoint" << std::endl;
+        exit(1);
+    }
+    checkpoint.failures = static_cast<int>(progress[0]);
+    checkpoint.completed.assign(progress + 1,
+                                progress + bytes / sizeof(uint64_t));
+    return checkpoint;
+}
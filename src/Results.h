@@ -0,0 +1,136 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include "BatchMeans.h"
+#include "CountMatrix.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+// frontmatter of a results file (csv files leave out the last 3 fields)
+// - shard k of N simulates draws [shardBegin(iterations, k, N),
+//   shardBegin(iterations, k + 1, N)), so merging all N shards gives exactly
+//   the counts of the unsharded run with the same seed; a whole run is shard 0
+//   of 1
+struct ResultsHeader {
+    std::string competition; // 'ucl', 'uel', or 'uecl'
+    int year = 0;
+    int iterations = 0; // # simulations of the whole run
+    uint64_t seed = 0;
+    std::chrono::system_clock::time_point timestamp; // start of run
+    uint64_t scenarioHash = 0;                       // DrawScenario::hash
+    int shard = 0;                                   // 0-based
+    int numShards = 1;
+};
+
+// raw counts of one shard of a run
+struct PartialResults {
+    ResultsHeader header;
+    CountMatrix counts;
+
+    explicit PartialResults(int numTeams) : counts(numTeams) {}
+};
+
+int shardBegin(int iterations, int shard, int numShards);
+
+// results csv: frontmatter, then home/away/total counts of every team pair
+// (and, given batch means, the half-widths of their 95% confidence intervals,
+// in percentage points; given expected counts (game h * numTeams + a), their
+// home/away/total sums, as home_rb/away_rb/total_rb)
+void writeResults(const CountMatrix &counts, const ResultsHeader &header,
+                  const std::filesystem::path &outputPath,
+                  const BatchMeans *batchMeans = nullptr,
+                  const std::vector<double> *expectedCounts = nullptr);
+
+// binary results file (native byte order, i.e. little-endian on all supported
+// platforms), meant to be memory-mapped (see MappedResults and
+// scripts/analysis.py):
+// - ResultsFileHeader (128 bytes)
+// - numSections sections, each a ResultsSectionHeader (16 bytes) followed by
+//   its payload, zero-padded to a multiple of 16 bytes; readers skip sections
+//   of unknown kinds
+constexpr char RESULTS_MAGIC[8] = {'D', 'R', 'A', 'W', 'R', 'E', 'S', '\0'};
+constexpr uint32_t RESULTS_VERSION = 1;
+
+struct ResultsFileHeader {
+    char magic[8];       // RESULTS_MAGIC
+    uint32_t version;    // RESULTS_VERSION
+    uint32_t numTeams;
+    char competition[8]; // NUL-padded
+    int32_t year;
+    uint32_t numSections;
+    uint64_t iterations; // # simulations of the whole run
+    uint64_t seed;
+    uint64_t scenarioHash;
+    uint32_t shard;
+    uint32_t numShards;
+    int64_t timestamp; // s since epoch
+    uint8_t reserved[56];
+};
+static_assert(sizeof(ResultsFileHeader) == 128);
+
+enum ResultsSectionKind : uint32_t {
+    COUNTS_SECTION = 1,   // int32 numTeams x numTeams, entry h * numTeams + a
+    DRAW_LOG_SECTION = 2, // one record per draw (see DrawLog.h)
+    CHECKPOINT_SECTION = 3, // uint64 # failed draws, then bitmap of completed
+                            // draws (bit i - first draw of shard)
+};
+
+struct ResultsSectionHeader {
+    uint32_t kind; // ResultsSectionKind
+    uint32_t reserved;
+    uint64_t bytes; // payload size, excluding padding
+};
+static_assert(sizeof(ResultsSectionHeader) == 16);
+
+ResultsFileHeader makeResultsFileHeader(const ResultsHeader &header,
+                                        int numTeams, uint32_t numSections);
+ResultsHeader makeResultsHeader(const ResultsFileHeader &fh);
+void writeBinaryResults(const PartialResults &results,
+                        const std::filesystem::path &outputPath);
+PartialResults readBinaryResults(const std::filesystem::path &path);
+
+// read-only memory map of a binary results file (exits if the file is not
+// one, or its counts section, if any, is malformed)
+class MappedResults {
+  public:
+    explicit MappedResults(const std::filesystem::path &path);
+    ~MappedResults();
+    MappedResults(const MappedResults &) = delete;
+    MappedResults &operator=(const MappedResults &) = delete;
+
+    const ResultsFileHeader &header() const;
+    // payload of the first section of the given kind (nullptr if none)
+    const void *section(uint32_t kind, uint64_t *bytes = nullptr) const;
+    const int32_t *counts() const; // nullptr if no counts section
+
+  private:
+    const unsigned char *data;
+    size_t size;
+};
+
+// interrupted Simulator::run: counts of the draws completed so far, which
+// draws those are, and how many of them failed at least once (draw i's random
+// numbers depend only on the seed and i, so the run can continue with the rest)
+struct Checkpoint {
+    PartialResults results;
+    std::vector<uint64_t> completed; // bit i - first draw of shard
+    int failures = 0;
+
+    explicit Checkpoint(PartialResults r) : results(std::move(r)) {}
+};
+
+// replaces the file atomically (via a temporary file)
+void writeCheckpoint(const Checkpoint &checkpoint,
+                     const std::filesystem::path &path);
+Checkpoint readCheckpoint(const std::filesystem::path &path);
+
+// sum of a complete set of shards of one run (exits if shards come from
+// different runs, or any shard is missing or repeated)
+PartialResults mergePartialResults(const std::vector<PartialResults> &shards);
+
+#endif // RESULTS_H
@@ -0,0 +1,152 @@
+#include "Scheduler.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+thread_local int currentWorkerIndex = -1;
+} // namespace
+
+Scheduler::Scheduler(int numWorkers) {
+    for (int i = 0; i < numWorkers; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < numWorkers; i++) {
+        threads.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread &t : threads) {
+        t.join();
+    }
+}
+
+int Scheduler::numWorkers() const { return static_cast<int>(workers.size()); }
+
+int Scheduler::workerIndex() { return currentWorkerIndex; }
+
+int Scheduler::numIdleWorkers() const {
+    return idleWorkers.load(std::memory_order_relaxed);
+}
+
+void Scheduler::submit(std::function<void()> task) {
+    numUnfinishedTasks.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        outerTasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void Scheduler::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    allFinished.wait(lock, [this]() {
+        return numUnfinishedTasks.load(std::memory_order_acquire) == 0;
+    });
+}
+
+bool Scheduler::spawn(Task task) {
+    if (currentWorkerIndex < 0) {
+        return false;
+    }
+    Worker &worker = *workers[currentWorkerIndex];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.size == DEQUE_CAPACITY) {
+            return false;
+        }
+        worker.tasks[(worker.head + worker.size) % DEQUE_CAPACITY] = task;
+        worker.size++;
+    }
+    numUnfinishedTasks.fetch_add(1, std::memory_order_relaxed);
+    workAvailable.notify_one();
+    return true;
+}
+
+void Scheduler::workerLoop(int index) {
+    currentWorkerIndex = index;
+    while (true) {
+        // own inner tasks, then stolen inner tasks, then outer tasks
+        if (helpOnce() || stealTask(index)) {
+            continue;
+        }
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (outerTasks.empty()) {
+                if (stopping) {
+                    return;
+                }
+                // spawns notify without holding mutex, so also wake up
+                // periodically to look for inner tasks to steal
+                idleWorkers.fetch_add(1, std::memory_order_relaxed);
+                workAvailable.wait_for(lock, std::chrono::milliseconds(1));
+                idleWorkers.fetch_sub(1, std::memory_order_relaxed);
+                continue;
+            }
+            task = std::move(outerTasks.front());
+            outerTasks.pop_front();
+        }
+        task();
+        finishTask();
+    }
+}
+
+bool Scheduler::helpOnce() {
+    if (currentWorkerIndex < 0) {
+        return false;
+    }
+    Worker &worker = *workers[currentWorkerIndex];
+    Task task;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.size == 0) {
+            return false;
+        }
+        worker.size--;
+        task = worker.tasks[(worker.head + worker.size) % DEQUE_CAPACITY];
+    }
+    task.run(task.arg);
+    finishTask();
+    return true;
+}
+
+bool Scheduler::stealTask(int thief) {
+    int n = numWorkers();
+    for (int i = 1; i < n; i++) {
+        Worker &victim = *workers[(thief + i) % n];
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.size == 0) {
+                continue;
+            }
+            task = victim.tasks[victim.head];
+            victim.head = (victim.head + 1) % DEQUE_CAPACITY;
+            victim.size--;
+        }
+        task.run(task.arg);
+        finishTask();
+        return true;
+    }
+    return false;
+}
+
+void Scheduler::finishTask() {
+    if (numUnfinishedTasks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(mutex);
+        allFinished.notify_all();
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// work-stealing scheduler shared by outer tasks (one per simulated draw) and
+// inner tasks (DFS searches spawned while testing a candidate game), with one
+// worker thread per core
+// - outer tasks go through a shared FIFO queue
+// - inner tasks go on the spawning worker's own deque: the owner pops the
+//   newest, idle workers steal the oldest
+// - idle workers prefer inner tasks to outer tasks, so spawned searches start
+//   as soon as a core frees up
+class Scheduler {
+  public:
+    // inner task: plain function pointer and argument, so spawning never
+    // allocates (spawns happen inside DFS)
+    struct Task {
+        void (*run)(void *arg);
+        void *arg;
+    };
+
+    explicit Scheduler(int numWorkers);
+    ~Scheduler();
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    int numWorkers() const;
+    static int workerIndex(); // index of calling worker, -1 if not a worker
+    int numIdleWorkers() const; // workers with nothing to run or steal
+
+    // outer tasks
+    void submit(std::function<void()> task);
+    void wait(); // block until all submitted and spawned tasks finished
+
+    // inner tasks (from workers only); returns false if task was not queued
+    // (not called from a worker, or deque full)
+    bool spawn(Task task);
+    // run newest of calling worker's own queued inner tasks; returns false if
+    // none queued
+    bool helpOnce();
+    // run calling worker's own queued inner tasks while pred() holds, instead
+    // of blocking (tasks stolen by other workers are waited out, not helped)
+    template <typename Pred> void helpWhile(Pred pred) {
+        while (pred()) {
+            if (!helpOnce()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+  private:
+    static constexpr int DEQUE_CAPACITY = 64;
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::array<Task, DEQUE_CAPACITY> tasks; // ring buffer
+        size_t head = 0;                        // oldest task
+        size_t size = 0;
+    };
+
+    void workerLoop(int index);
+    bool stealTask(int thief);
+    void finishTask();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex; // guards outerTasks, stopping
+    std::condition_variable workAvailable;
+    std::condition_variable allFinished;
+    std::deque<std::function<void()>> outerTasks;
+    bool stopping = false;
+    std::atomic<int> numUnfinishedTasks{0};
+    std::atomic<int> idleWorkers{0};
+};
+
+#endif // SCHEDULER_H
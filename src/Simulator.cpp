@@ -1,14 +1,25 @@
 #include "Simulator.h"
+#include "BatchMeans.h"
+#include "CountMatrix.h"
 #include "Draw.h"
+#include "DrawLog.h"
+#include "FeasibilityCache.h"
+#include "PortfolioStats.h"
+#include "Results.h"
+#include "Scheduler.h"
+#include "allocations.h"
 #include "globals.h"
 #include "utils.h"
-#include <BS_thread_pool/BS_thread_pool.hpp>
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
-#include <fstream>
 #include <indicators/indicators.hpp>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
 #include <string>
 #include <thread>
 
@@ -20,16 +31,73 @@ Simulator::Simulator(int y, std::string c, std::string teamsPath)
                                        : teamsPath);
     bannedCountryMatchups =
         readTXTCountries("data/" + std::to_string(year) + "/banned.txt");
+    // built once, shared by every draw of every run
+    if (competition == "ucl")
+        scenario = UCLDraw::createScenario(teams, bannedCountryMatchups);
+    else if (competition == "uel")
+        scenario = UELDraw::createScenario(teams, bannedCountryMatchups);
+    else if (competition == "uecl")
+        scenario = UECLDraw::createScenario(teams, bannedCountryMatchups);
 }
 
-void Simulator::run(int iterations, std::string output) const {
-    std::unordered_map<std::string, int> counts; // {homeInd}:{awayInd} -> count
+namespace {
+
+// fewest batches an adaptive run stops after, so variance estimates are
+// meaningful
+constexpr int MIN_ADAPTIVE_BATCHES = 10;
+
+// what a worker added to its counts since the last checkpoint, guarded with
+// them so a checkpoint copies a consistent snapshot of each worker (workers
+// only wait while their own slice is copied)
+struct alignas(64) WorkerProgress {
+    std::mutex mutex;
+    std::vector<int> completed; // draw inds
+    int failures = 0;
+};
+
+// a worker's sums of Rao-Blackwellized estimates (see Draw::getPickCredits)
+struct alignas(64) WorkerCredits {
+    std::vector<double> games;       // h * numTeams + a
+    std::vector<double> pairSquares; // i * numTeams + j (i < j), of the
+                                     // pair's estimate in each draw
+};
+
+} // namespace
+
+SimulatorStats Simulator::run(int iterations, std::string output,
+                              const SimulatorOptions &options) const {
+    // optionally continue an interrupted run: same draws, seed and start time,
+    // so results are identical to an uninterrupted run
+    std::unique_ptr<Checkpoint> resumed;
+    if (!options.resume.empty()) {
+        resumed = std::make_unique<Checkpoint>(readCheckpoint(options.resume));
+        const ResultsHeader &h = resumed->results.header;
+        if (h.competition != competition || h.year != year ||
+            h.iterations != iterations || h.scenarioHash != scenario->hash ||
+            h.shard != options.shard || h.numShards != options.numShards ||
+            (options.seed && *options.seed != h.seed)) {
+            std::cerr << "Checkpoint " << options.resume
+                      << " is from a different run" << std::endl;
+            exit(1);
+        }
+    }
 
     // compute results output path
     std::chrono::system_clock::time_point start =
-        std::chrono::system_clock::now();
+        resumed ? resumed->results.header.timestamp
+                : std::chrono::system_clock::now();
+    const bool sharded = options.numShards > 1;
     std::filesystem::path outputPath = output;
-    if (outputPath.empty()) {
+    if (outputPath.empty() && sharded) {
+        // no timestamp, so a rerun of a failed shard replaces its file
+        std::string fileName =
+            competition + "_" + std::to_string(year) + "_" +
+            std::to_string(iterations) + "_shard" +
+            std::to_string(options.shard) + "of" +
+            std::to_string(options.numShards) + ".bin";
+        // example path: `results/ucl_2025_1000_shard2of8.bin`
+        outputPath = "results/" + fileName;
+    } else if (outputPath.empty()) {
         std::string timestamp = formatSystemTimePoint(start, "%Y%m%d_%H%M%S");
         std::string fileName = competition + "_" + std::to_string(year) + "_" +
                                std::to_string(iterations) + "_" + timestamp +
@@ -38,6 +106,17 @@ void Simulator::run(int iterations, std::string output) const {
         outputPath = "results/" + fileName;
     }
 
+    // draws simulated by this run (all of them, unless sharded)
+    const int first = shardBegin(iterations, options.shard, options.numShards);
+    const int last =
+        shardBegin(iterations, options.shard + 1, options.numShards);
+    const int numDraws = last - first;
+    const bool adaptive = options.targetCI > 0;
+    // adaptive and Rao-Blackwellized runs can't be resumed, so they aren't
+    // checkpointed
+    const int checkpointSeconds =
+        adaptive || options.raoBlackwell ? 0 : options.checkpointSeconds;
+
     // set up progress bar
     indicators::show_console_cursor(false);
     indicators::BlockProgressBar bar{
@@ -45,177 +124,436 @@ void Simulator::run(int iterations, std::string output) const {
         indicators::option::ForegroundColor{indicators::Color::white},
         indicators::option::FontStyles{
             std::vector<indicators::FontStyle>{indicators::FontStyle::bold}},
-        indicators::option::MaxProgress{iterations},
+        indicators::option::MaxProgress{numDraws},
         indicators::option::ShowElapsedTime{true},
         indicators::option::ShowRemainingTime{true},
     };
 
-    std::cout << "Simulating " << iterations << " draws..." << std::endl;
+    // draw i's random numbers are keyed by (seed, i), so results are
+    // reproducible from the seed alone
+    const uint64_t seed =
+        resumed        ? resumed->results.header.seed
+        : options.seed ? *options.seed
+                       : (uint64_t{std::random_device{}()} << 32) |
+                             std::random_device{}();
+
+    // describes this run in results files and the draw log
+    ResultsHeader header{competition, year, iterations, seed, start,
+                         scenario->hash, options.shard, options.numShards};
+
+    if (sharded) {
+        std::cout << "Simulating shard " << options.shard << "/"
+                  << options.numShards << ": draws " << first << "-"
+                  << last - 1 << " of " << iterations << " (seed " << seed
+                  << ")..." << std::endl;
+    } else {
+        std::cout << "Simulating " << iterations << " draws (seed " << seed
+                  << ")..." << std::endl;
+    }
+
+    // one scheduler runs both simulations and their DFS searches
+    const int numThreads = options.threads > 0
+                               ? options.threads
+                               : std::thread::hardware_concurrency();
+    Scheduler scheduler(numThreads);
+
+    // optional feasibility cache shared by all draws, sized to the largest
+    // power of 2 # of slots that fits in cacheMB
+    std::unique_ptr<FeasibilityCache> sharedCache;
+    if (options.cacheMB > 0) {
+        int capacityLog2 = 2;
+        while ((size_t{1} << (capacityLog2 + 1)) * sizeof(uint64_t) <=
+               static_cast<size_t>(options.cacheMB) << 20) {
+            capacityLog2++;
+        }
+        sharedCache = std::make_unique<FeasibilityCache>(capacityLog2);
+    }
+
+    // ordering win rates shared by all draws, so every candidate test's
+    // portfolio learns from the run so far
+    PortfolioStats portfolioStats;
+
+    // each worker reuses one draw (created on its first simulation), reset
+    // before each simulation
+    std::vector<std::unique_ptr<Draw>> workerDraws(numThreads);
 
-    // set up thread pools
-    const int numThreads = std::thread::hardware_concurrency();
-    BS::thread_pool pool(numThreads);
-    BS::thread_pool dfsPool(numThreads * 3);
+    // optional log of every draw, written by its own thread
+    std::unique_ptr<DrawLogWriter> drawLog;
+    if (!options.drawLog.empty()) {
+        drawLog = std::make_unique<DrawLogWriter>(
+            options.drawLog, header, static_cast<int>(teams.size()),
+            numThreads);
+    }
 
-    // each thread keeps its own counts
-    std::vector<std::unordered_map<std::string, int>> threadCounts(numThreads);
-    std::vector<std::thread::id> threadIds = pool.get_thread_ids();
-    std::unordered_map<std::thread::id, int> indexByThreadId;
-    for (int i = 0; static_cast<size_t>(i) < threadIds.size(); i++) {
-        indexByThreadId[threadIds[i]] = i;
+    // each worker keeps its own counts
+    CountMatrix threadCounts(static_cast<int>(teams.size()), numThreads);
+    std::vector<WorkerProgress> progress(numThreads);
+    const int numTeams = static_cast<int>(teams.size());
+    std::vector<WorkerCredits> workerCredits(numThreads);
+    if (options.raoBlackwell) {
+        for (WorkerCredits &c : workerCredits) {
+            c.games.assign(numTeams * numTeams, 0.0);
+            c.pairSquares.assign(numTeams * numTeams, 0.0);
+        }
     }
 
+    // draws completed as of the last checkpoint (bit i - first)
+    std::vector<uint64_t> checkpointed((numDraws + 63) / 64, 0);
+    int numResumed = 0;
+    if (resumed) {
+        checkpointed = resumed->completed;
+        threadCounts.addSlice(0, resumed->results.counts, 0);
+        progress[0].failures = resumed->failures;
+        for (uint64_t word : checkpointed) {
+            numResumed += __builtin_popcountll(word);
+        }
+        std::cout << "Resuming from " << options.resume << " (" << numResumed
+                  << " draws done)" << std::endl;
+    }
+    std::filesystem::path checkpointPath = outputPath;
+    checkpointPath += ".ckpt";
+    auto writeRunCheckpoint = [&] {
+        Checkpoint checkpoint{PartialResults(static_cast<int>(teams.size()))};
+        checkpoint.results.header = header;
+        std::vector<int> newlyCompleted;
+        for (int w = 0; w < numThreads; w++) {
+            std::lock_guard<std::mutex> lock(progress[w].mutex);
+            checkpoint.results.counts.addSlice(0, threadCounts, w);
+            checkpoint.failures += progress[w].failures;
+            newlyCompleted.insert(newlyCompleted.end(),
+                                  progress[w].completed.begin(),
+                                  progress[w].completed.end());
+            progress[w].completed.clear();
+        }
+        for (int i : newlyCompleted) {
+            checkpointed[(i - first) / 64] |= uint64_t{1} << ((i - first) % 64);
+        }
+        checkpoint.completed = checkpointed;
+        writeCheckpoint(checkpoint, checkpointPath);
+    };
+
     // track progress
-    std::atomic<int> failures{0};
-    std::atomic<int> completed{0};
+    std::atomic<int> failures{resumed ? resumed->failures : 0};
+    std::atomic<int> completed{numResumed};
     std::atomic<int> duration{0}; // ms
 
+    uint64_t dfsSearchesStart = totalDFSSearches();
+    uint64_t dfsAllocationsStart = totalDFSAllocations();
+
     auto tStart = std::chrono::steady_clock::now();
 
-    for (int i = 0; i < iterations; i++) {
-        pool.detach_task([this, &dfsPool, &indexByThreadId, &threadCounts,
-                          &duration, &completed, &failures] {
-            auto t0 = std::chrono::steady_clock::now();
-            bool success = false;
-            std::unique_ptr<Draw> d;
-            std::vector<Game> initialGames;
-            bool hasFailed = false;
-
-            while (!success) {
-                if (competition == "ucl")
-                    d.reset(new UCLDraw(teams, initialGames,
-                                        bannedCountryMatchups));
-                else if (competition == "uel")
-                    d.reset(new UELDraw(teams, initialGames,
-                                        bannedCountryMatchups));
-                else if (competition == "uecl")
-                    d.reset(new UECLDraw(teams, initialGames,
-                                         bannedCountryMatchups));
-                else {
-                    std::cout << "Invalid competition specified" << std::endl;
-                    exit(1);
+    // simulate draw i, with a draw reused by the calling worker
+    auto simulateDraw = [this, seed, numTeams, &scheduler, &options,
+                         &workerDraws, &threadCounts, &progress,
+                         &workerCredits, &drawLog, &sharedCache,
+                         &portfolioStats, &duration, &completed,
+                         &failures](int i) {
+        auto t0 = std::chrono::steady_clock::now();
+        bool success = false;
+        std::unique_ptr<Draw> &d = workerDraws[Scheduler::workerIndex()];
+        if (!d) {
+            d = createDraw(sharedCache.get(), &portfolioStats,
+                           options.dfsBudget);
+            d->setPickCredits(options.raoBlackwell);
+        }
+        std::vector<Game> initialGames;
+        std::vector<double> credits; // of every attempt's picks
+        bool hasFailed = false;
+        uint32_t attempt = 0;
+
+        while (!success) {
+            // stream: iteration, attempt (so a restarted draw doesn't
+            // repeat the choices that failed)
+            d->reset(initialGames);
+            d->setRandomStream(seed, (uint64_t{attempt++} << 32) |
+                                         static_cast<uint32_t>(i));
+            d->draw(scheduler);
+            if (options.raoBlackwell) {
+                // a restart keeps the picks (and so the credits) so far
+                const std::vector<double> &c = d->getPickCredits();
+                credits.resize(c.size(), 0.0);
+                for (size_t k = 0; k < c.size(); k++) {
+                    credits[k] += c[k];
                 }
-                d->draw(dfsPool);
-                success = d->verifyDraw();
-                if (!success) {
-                    // if failed, replace initial games with current picked game
-                    // state prior to failure
-                    initialGames = d->getPickedGames();
-                    hasFailed = true;
+            }
+            success = d->verifyDraw();
+            if (!success) {
+                // if failed, replace initial games with current picked game
+                // state prior to failure
+                initialGames = d->getPickedGames();
+                hasFailed = true;
+            }
+        }
+
+        // update failure count
+        if (hasFailed) {
+            failures.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // update worker counts (and draw log)
+        const int w = Scheduler::workerIndex();
+        const std::vector<Game> games = d->getPickedGames();
+        {
+            std::lock_guard<std::mutex> lock(progress[w].mutex);
+            threadCounts.add(w, games);
+            progress[w].completed.push_back(i);
+            progress[w].failures += hasFailed;
+        }
+        if (drawLog) {
+            drawLog->add(w, i, games);
+        }
+        if (options.raoBlackwell) {
+            WorkerCredits &c = workerCredits[w];
+            for (size_t k = 0; k < credits.size(); k++) {
+                c.games[k] += credits[k];
+            }
+            for (int h = 0; h < numTeams - 1; h++) {
+                for (int a = h + 1; a < numTeams; a++) {
+                    double pair =
+                        credits[h * numTeams + a] + credits[a * numTeams + h];
+                    c.pairSquares[h * numTeams + a] += pair * pair;
                 }
             }
+        }
+
+        // update completed count
+        completed.fetch_add(1, std::memory_order_relaxed);
+
+        // update total duration
+        auto t1 = std::chrono::steady_clock::now();
+        auto diff =
+            std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
+        duration.fetch_add(diff.count(), std::memory_order_relaxed);
+    };
+
+    // adaptive runs simulate batches of draws until every pair's confidence
+    // interval is narrow enough (or iterations run out); stopping is only
+    // decided between batches, so it depends only on the seed
+    BatchMeans batchMeans(static_cast<int>(teams.size()));
+    const int batchDraws = adaptive ? options.batchDraws : numDraws;
+    int end = first; // draws [first, end) submitted
+    auto lastCheckpoint = std::chrono::steady_clock::now();
+    while (end < last) {
+        const int batchEnd = std::min(last, end + batchDraws);
+        for (int i = end; i < batchEnd; i++) {
+            if ((checkpointed[(i - first) / 64] >> ((i - first) % 64)) & 1) {
+                continue;
+            }
+            scheduler.submit([&simulateDraw, i] { simulateDraw(i); });
+        }
+        const int batchStart = end;
+        end = batchEnd;
 
-            // update failure count
-            if (hasFailed) {
-                failures.fetch_add(1, std::memory_order_relaxed);
+        // update progress bar, checkpoint periodically
+        while (completed.load() < end - first) {
+            int i = completed.load();
+            int simulated = i - numResumed;
+            auto tCurrent = std::chrono::steady_clock::now();
+            bar.set_option(indicators::option::PostfixText{
+                std::to_string(i) + "/" + std::to_string(numDraws) + " (" +
+                std::to_string(duration.load() /
+                               static_cast<float>(1000 * simulated)) +
+                "s / " +
+                std::to_string(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        tCurrent - tStart)
+                        .count() /
+                    static_cast<float>(1000 * simulated)) +
+                "s)"});
+            bar.set_progress(i);
+            if (checkpointSeconds > 0 &&
+                tCurrent - lastCheckpoint >=
+                    std::chrono::seconds(checkpointSeconds)) {
+                writeRunCheckpoint();
+                lastCheckpoint = tCurrent;
             }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
 
-            // update thread counts
-            std::thread::id threadId = std::this_thread::get_id();
-            std::vector<Game> pickedGames = d->getPickedGames();
-            for (const Game &g : pickedGames) {
-                threadCounts[indexByThreadId.at(threadId)]
-                            [std::to_string(g.h) + ":" + std::to_string(g.a)] +=
-                    1;
+        scheduler.wait();
+        if (adaptive) {
+            batchMeans.addBatch(threadCounts.reduce(), batchEnd - batchStart);
+            if (batchMeans.numBatches() >= MIN_ADAPTIVE_BATCHES &&
+                100 * batchMeans.maxPairHalfWidth(CI_95_Z) <=
+                    options.targetCI) {
+                break;
             }
+        }
+    }
+    const int numDone = end - first;
+    const int numSimulated = numDone - numResumed; // by this process
 
-            // update completed count
-            completed.fetch_add(1, std::memory_order_relaxed);
-
-            // update total duration
-            auto t1 = std::chrono::steady_clock::now();
-            auto diff =
-                std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
-            duration.fetch_add(diff.count(), std::memory_order_relaxed);
-        });
-    }
-
-    // update progress bar
-    while (completed.load() < iterations) {
-        int i = completed.load();
-        auto tCurrent = std::chrono::steady_clock::now();
-        bar.set_option(indicators::option::PostfixText{
-            std::to_string(i) + "/" + std::to_string(iterations) + " (" +
-            std::to_string(duration.load() / static_cast<float>(1000 * i)) +
-            "s / " +
-            std::to_string(
-                std::chrono::duration_cast<std::chrono::milliseconds>(tCurrent -
-                                                                      tStart)
-                    .count() /
-                static_cast<float>(1000 * i)) +
-            "s)"});
-        bar.set_progress(i);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
-
-    pool.wait();
+    scheduler.wait();
+    if (drawLog) {
+        if (adaptive) {
+            // stopped after numDone draws, not iterations
+            drawLog->setIterations(numDone);
+        }
+        drawLog->close();
+    }
 
     // progress bar complete
     auto tCurrent = std::chrono::steady_clock::now();
     bar.set_option(indicators::option::PostfixText{
-        std::to_string(iterations) + "/" + std::to_string(iterations) + " (" +
+        std::to_string(numDone) + "/" + std::to_string(numDone) + " (" +
         std::to_string(duration.load() /
-                       static_cast<float>(1000 * iterations)) +
+                       static_cast<float>(1000 * numSimulated)) +
         "s / " +
         std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
                            tCurrent - tStart)
                            .count() /
-                       static_cast<float>(1000 * iterations)) +
+                       static_cast<float>(1000 * numSimulated)) +
         "s)"});
-    bar.set_progress(iterations);
+    bar.set_progress(numDone);
     bar.mark_as_completed();
     indicators::show_console_cursor(true);
 
     // combine thread counts
-    for (std::unordered_map<std::string, int> &local : threadCounts) {
-        for (std::pair<const std::string, int> &kv : local) {
-            counts[kv.first] += kv.second;
+    CountMatrix counts = threadCounts.reduce();
+    if (adaptive) {
+        header.iterations = numDone;
+        double achieved = 100 * batchMeans.maxPairHalfWidth(CI_95_Z);
+        std::cout << "Max 95% CI half-width: " << achieved << " pp after "
+                  << numDone << " draws (target " << options.targetCI << " pp)"
+                  << std::endl;
+        if (achieved > options.targetCI ||
+            batchMeans.numBatches() < MIN_ADAPTIVE_BATCHES) {
+            std::cout << "Target not reached: increase iterations"
+                      << std::endl;
         }
     }
 
-    writeResults(counts, outputPath, start, iterations);
+    // combine worker estimates and compare their per-draw variance with that
+    // of plain counts (each pair meets at most once per draw, so its count's
+    // variance is p (1 - p))
+    SimulatorStats stats;
+    stats.draws = numSimulated;
+    stats.seconds = std::chrono::duration<double>(tCurrent - tStart).count();
+    std::vector<double> expectedCounts;
+    if (options.raoBlackwell) {
+        expectedCounts.assign(numTeams * numTeams, 0.0);
+        std::vector<double> pairSquares(numTeams * numTeams, 0.0);
+        for (const WorkerCredits &c : workerCredits) {
+            for (int k = 0; k < numTeams * numTeams; k++) {
+                expectedCounts[k] += c.games[k];
+                pairSquares[k] += c.pairSquares[k];
+            }
+        }
+        double plainVariance = 0;
+        double rbVariance = 0;
+        for (int h = 0; h < numTeams - 1; h++) {
+            for (int a = h + 1; a < numTeams; a++) {
+                double p = static_cast<double>(counts.get(h, a) +
+                                               counts.get(a, h)) /
+                           numDone;
+                double mean = (expectedCounts[h * numTeams + a] +
+                               expectedCounts[a * numTeams + h]) /
+                              numDone;
+                plainVariance += p * (1 - p);
+                rbVariance +=
+                    pairSquares[h * numTeams + a] / numDone - mean * mean;
+            }
+        }
+        if (rbVariance > 0) {
+            stats.varianceReduction = plainVariance / rbVariance;
+        }
+    }
+
+    // shards are always binary, so they can be merged; whole runs are binary
+    // if the output path asks for it
+    if (sharded || outputPath.extension() == ".bin") {
+        PartialResults results(static_cast<int>(teams.size()));
+        results.header = header;
+        results.counts = std::move(counts);
+        writeBinaryResults(results, outputPath);
+    } else {
+        writeResults(counts, header, outputPath,
+                     adaptive ? &batchMeans : nullptr,
+                     options.raoBlackwell ? &expectedCounts : nullptr);
+    }
+
+    // run finished, so its checkpoint is obsolete
+    if (checkpointSeconds > 0) {
+        std::filesystem::remove(checkpointPath);
+    }
 
     const int numFailures = failures.load();
     std::cout << "Failures: " << numFailures << std::endl;
     std::cout << "Avg time per thread: "
-              << duration.load() / static_cast<float>(1000 * iterations) << "s"
-              << std::endl;
+              << duration.load() / static_cast<float>(1000 * numSimulated)
+              << "s" << std::endl;
     std::cout << "Elapsed time per simulation: "
               << std::chrono::duration_cast<std::chrono::milliseconds>(
                      tCurrent - tStart)
                          .count() /
-                     static_cast<float>(1000 * iterations)
+                     static_cast<float>(1000 * numSimulated)
               << "s" << std::endl;
+    std::cout << "DFS searches: " << totalDFSSearches() - dfsSearchesStart
+              << " (heap allocations during search: "
+              << totalDFSAllocations() - dfsAllocationsStart << ")"
+              << std::endl;
+    if (sharedCache) {
+        uint64_t lookups = sharedCache->numLookups();
+        // fixed precision, so caches under 1 MB don't print as 0 MB
+        std::ostringstream size;
+        size << std::fixed << std::setprecision(2)
+             << sharedCache->memoryBytes() / static_cast<double>(1 << 20);
+        std::cout << "Feasibility cache: " << size.str() << " MB, "
+                  << sharedCache->numEntries() << " entries, "
+                  << sharedCache->numHits() << "/" << lookups << " hits ("
+                  << (lookups ? 100.0 * sharedCache->numHits() / lookups : 0)
+                  << "%), " << sharedCache->numEvictions() << " evictions"
+                  << std::endl;
+    }
+    if (portfolioStats.numContested()) {
+        std::cout << "DFS orderings (" << portfolioStats.numContested()
+                  << " contested tests):" << std::endl;
+        for (int o = 0; o < NUM_DFS_ORDERINGS; o++) {
+            uint64_t trials = portfolioStats.numTrials(o);
+            std::cout << "  " << orderingName(o) << ": "
+                      << portfolioStats.numWins(o) << "/" << trials << " wins ("
+                      << (trials ? 100.0 * portfolioStats.numWins(o) / trials
+                                 : 0)
+                      << "%), " << portfolioStats.numAnswers(o)
+                      << " answers, "
+                      << portfolioStats.meanAnswerNodes(o)
+                      << " nodes per answer" << std::endl;
+        }
+    }
+    if (options.raoBlackwell) {
+        std::cout << "Rao-Blackwell variance reduction: "
+                  << stats.varianceReduction << "x ("
+                  << stats.varianceReduction * numSimulated / stats.seconds
+                  << " effective draws/s)" << std::endl;
+    }
+    if (drawLog) {
+        std::cout << "Logged " << drawLog->numRecords() << " draws to "
+                  << options.drawLog << "." << std::endl;
+    }
     std::cout << "Wrote results to " << outputPath.string() << "." << std::endl;
+    return stats;
 }
 
-void Simulator::writeResults(const std::unordered_map<std::string, int> &counts,
-                             const std::filesystem::path &outputPath,
-                             const std::chrono::system_clock::time_point &tp,
-                             int iterations) const {
-    std::filesystem::create_directories(outputPath.parent_path());
-    std::ofstream out(outputPath);
-    // write frontmatter
-    out << "---\n";
-    out << "timestamp: " << formatSystemTimePoint(tp, "%Y-%m-%d %H:%M:%S")
-        << "\n";
-    out << "competition: " << competition << "\n";
-    out << "year: " << year << "\n";
-    out << "simulations: " << iterations << "\n";
-    out << "---\n";
-    // write results
-    out << "t1,t2,home,away,total\n";
-    for (size_t i = 0; i < teams.size() - 1; i++) {
-        for (size_t j = i + 1; j < teams.size(); j++) {
-            std::string homeAwayKey =
-                std::to_string(i) + ":" + std::to_string(j);
-            std::string awayHomeKey =
-                std::to_string(j) + ":" + std::to_string(i);
-            int homeAwayCounts = get_or(counts, homeAwayKey, 0);
-            int awayHomeCounts = get_or(counts, awayHomeKey, 0);
-            out << i << "," << j << "," << homeAwayCounts << ","
-                << awayHomeCounts << "," << homeAwayCounts + awayHomeCounts
-                << std::endl;
-        }
-    }
-}
\ No newline at end of file
+std::unique_ptr<Draw>
+Simulator::createDraw(FeasibilityCache *feasibilityCache,
+                      PortfolioStats *portfolioStats,
+                      const DFSBudget &dfsBudget) const {
+    // pick the DrawEngine instantiation specialized for this competition
+    std::unique_ptr<Draw> d;
+    if (competition == "ucl")
+        d = std::make_unique<UCLDraw>(scenario);
+    else if (competition == "uel")
+        d = std::make_unique<UELDraw>(scenario);
+    else if (competition == "uecl")
+        d = std::make_unique<UECLDraw>(scenario);
+    else {
+        std::cout << "Invalid competition specified" << std::endl;
+        exit(1);
+    }
+    if (feasibilityCache) {
+        d->setFeasibilityCache(feasibilityCache);
+    }
+    d->setPortfolioStats(portfolioStats);
+    d->setDFSBudget(dfsBudget);
+    return d;
+}
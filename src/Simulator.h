@@ -1,30 +1,68 @@
 #ifndef SIMULATOR_H
 #define SIMULATOR_H
 
+#include "CountMatrix.h"
 #include "Draw.h"
+#include "FeasibilityCache.h"
+#include "PortfolioStats.h"
+#include "Results.h"
 #include "globals.h"
-#include <chrono>
-#include <filesystem>
+#include <memory>
+#include <optional>
 #include <string>
-#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+// optional Simulator::run settings
+struct SimulatorOptions {
+    int cacheMB = 0; // size of feasibility cache shared by all draws (0 -> each
+                     // worker keeps its own across its draws)
+    DFSBudget dfsBudget; // node budgets of each candidate game test
+    std::optional<uint64_t> seed; // results depend only on seed, not on #
+                                  // threads, unless a draw fails (a timed
+                                  // out test restarts it; random if unset)
+    int threads = 0; // # scheduler workers (0 -> one per core)
+    int shard = 0;     // with numShards > 1, simulate only this shard of the
+    int numShards = 1; // iterations and write partial results (see Results.h)
+    std::string drawLog; // if set, path of a log of every draw (see DrawLog.h)
+    int checkpointSeconds = 60; // period of checkpoints to `<output>.ckpt` (0
+                                // -> none)
+    std::string resume; // if set, checkpoint to continue from
+    double targetCI = 0; // if > 0, stop once every pair's 95% CI half-width
+                         // (in pp) is below it (iterations is then the cap)
+    int batchDraws = 1000; // batch size of targetCI's batch means
+    bool raoBlackwell = false; // also estimate each game's probability from
+                               // its pick probabilities (see
+                               // Draw::setPickCredits)
+};
+
+// summary of a Simulator::run
+struct SimulatorStats {
+    int draws = 0;                // simulated by the run
+    double seconds = 0;           // elapsed
+    double varianceReduction = 1; // sum over pairs of the per-draw variance
+                                  // of their plain count / that of their
+                                  // Rao-Blackwellized estimate
+};
+
 class Simulator {
   public:
     Simulator(int year, std::string competition, std::string teamsPath = "");
-    void run(int iterations, std::string output = "") const;
+    SimulatorStats
+    run(int iterations, std::string output = "",
+        const SimulatorOptions &options = SimulatorOptions()) const;
 
   private:
-    void writeResults(const std::unordered_map<std::string, int> &counts,
-                      const std::filesystem::path &outputPath,
-                      const std::chrono::system_clock::time_point &tp,
-                      int iterations) const;
+    std::unique_ptr<Draw>
+    createDraw(FeasibilityCache *feasibilityCache,
+               PortfolioStats *portfolioStats,
+               const DFSBudget &dfsBudget) const;
 
     int year;
     std::string competition; // 'ucl', 'uel', or 'uecl'
     std::vector<Team> teams;
     std::unordered_set<std::string> bannedCountryMatchups;
+    std::shared_ptr<const DrawScenario> scenario;
 };
 
 #endif // SIMULATOR_H
\ No newline at end of file
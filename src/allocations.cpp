@@ -0,0 +1,38 @@
+#include "allocations.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local uint64_t numThreadAllocations = 0;
+std::atomic<uint64_t> numDFSSearches{0};
+std::atomic<uint64_t> numDFSAllocations{0};
+} // namespace
+
+void *operator new(std::size_t size) {
+    numThreadAllocations++;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+uint64_t threadAllocations() { return numThreadAllocations; }
+
+void recordDFSAllocations(uint64_t allocations) {
+    numDFSSearches.fetch_add(1, std::memory_order_relaxed);
+    numDFSAllocations.fetch_add(allocations, std::memory_order_relaxed);
+}
+
+uint64_t totalDFSSearches() {
+    return numDFSSearches.load(std::memory_order_relaxed);
+}
+
+uint64_t totalDFSAllocations() {
+    return numDFSAllocations.load(std::memory_order_relaxed);
+}
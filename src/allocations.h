@@ -0,0 +1,19 @@
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+#include <cstdint>
+
+// heap allocation counting (global operator new is replaced in
+// allocations.cpp), used to confirm that warm DFS workers do not allocate
+
+// # heap allocations made by the calling thread so far
+uint64_t threadAllocations();
+
+// record a finished DFS search and the # heap allocations made during it
+void recordDFSAllocations(uint64_t allocations);
+
+// # DFS searches and heap allocations made during them, over all threads
+uint64_t totalDFSSearches();
+uint64_t totalDFSAllocations();
+
+#endif // ALLOCATIONS_H
@@ -1,7 +1,11 @@
 #ifndef GLOBALS_H
 #define GLOBALS_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -30,6 +34,7 @@ struct Team {
 struct Game {
     int h; // home team index (0-based)
     int a; // away team index (0-based)
+    Game() : h(-1), a(-1) {}
     Game(int home, int away) : h(home), a(away) {}
     bool operator==(const Game &rhs) {
         return (h == rhs.h && a == rhs.a);
@@ -45,37 +50,134 @@ struct TeamVerifier {
     std::unordered_map<int, int> numGamesByPot;
 };
 
+// upper bounds on draw dimensions, used to size DFSContext arrays
+constexpr int MAX_POTS = 6;
+constexpr int MAX_TEAMS = 64;
+constexpr int MAX_COUNTRIES = 64;
+constexpr int MAX_GAMES = 160; // games in a draw, used to size DFS frame
+                               // stacks and paths
+
+// game locations, used to index per-location DFSContext fields
+constexpr int HOME = 0;
+constexpr int AWAY = 1;
+
 // current draw state, used in DFS
+// - pots are 0-based indices, countries are ids interned by
+//   DrawEngine::createScenario
+// - team, pot and country sets are bitsets (bit i set -> team/pot/country i
+//   in set)
+// - trivially copyable and free of heap storage, so each DFS worker starts
+//   from a plain copy of Draw::state
 struct DFSContext {
-    std::vector<Game> pickedGames;
-    std::unordered_map<std::string, int>
-        numGamesByPotPair; // {home pot}:{away pot} -> # picked games
-    std::unordered_map<int, int>
-        numHomeGamesByTeamInd; // team ind -> # picked home games
-    std::unordered_map<int, int>
-        numAwayGamesByTeamInd; // team ind -> # picked away games
-    std::unordered_map<std::string, int>
-        numGamesByTeamIndOppCountry; // {team ind}:{opp country} -> count
-    std::unordered_map<std::string, bool>
-        isPickedByTeamIndOppPotLocation; // {team ind}:{opp pot}:{h/a}
-    std::unordered_set<std::string>
-        pickedGamesTeamInds; // {home team ind}:{away team ind} per picked game
-    std::vector<std::unordered_set<int>>
-        needsHomeAgainstPot; // pot ind (0-based) -> set of team inds
-                             // with unscheduled home games against
-                             // this pot
-    std::vector<std::unordered_set<int>>
-        needsAwayAgainstPot; // pot ind (0-based) -> set of team inds
-                             // with unscheduled away games against
-                             // this pot
-    std::unordered_map<std::string,
-                       int>
-        countryHomeNeeds; // {country}:{pot} -> global count of country's teams
-                          // that need home game against pot
-    std::unordered_map<std::string,
-                       int>
-        countryAwayNeeds; // {country}:{pot} -> global count of country's teams
-                          // that need away game against pot
+    int numPickedGames = 0;
+    uint64_t hash = 0; // Zobrist hash of picked games (see gameHash)
+    std::array<std::array<uint8_t, MAX_POTS>, MAX_POTS>
+        numGamesByPotPair{}; // [home pot][away pot] -> # picked games
+    std::array<uint8_t, MAX_TEAMS>
+        numHomeGamesByTeamInd{}; // team ind -> # picked home games
+    std::array<uint8_t, MAX_TEAMS>
+        numAwayGamesByTeamInd{}; // team ind -> # picked away games
+    std::array<uint64_t, MAX_TEAMS>
+        facedCountriesByTeamInd{}; // team ind -> opp countries faced at least
+                                   // once (twice -> see maxedTeamsByCountry)
+    std::array<std::array<uint8_t, 2>, MAX_TEAMS>
+        oppPotsByTeamIndLocation{}; // [team ind][HOME/AWAY] -> opp pots
+                                    // played at this location
+    std::array<uint64_t, MAX_TEAMS>
+        oppsByTeamInd{}; // team ind -> picked opps (home or away)
+    std::array<uint64_t, MAX_POTS>
+        needsHomeAgainstPot{}; // pot -> teams with unscheduled home games
+                               // against this pot
+    std::array<uint64_t, MAX_POTS>
+        needsAwayAgainstPot{}; // pot -> teams with unscheduled away games
+                               // against this pot
+    std::array<std::array<uint8_t, MAX_POTS>, MAX_COUNTRIES>
+        countryHomeNeeds{}; // [country][pot] -> global count of country's
+                            // teams that need home game against pot
+    std::array<std::array<uint8_t, MAX_POTS>, MAX_COUNTRIES>
+        countryAwayNeeds{}; // [country][pot] -> global count of country's
+                            // teams that need away game against pot
+
+    // legality kernel, maintained by Draw::dfsUpdateLegalMasks
+    std::array<uint64_t, MAX_TEAMS>
+        legalAwayOppsByTeamInd{}; // team ind -> teams it can still host
+    std::array<uint64_t, MAX_TEAMS>
+        legalHomeOppsByTeamInd{}; // team ind -> teams it can still visit
+    uint64_t homeCompleteTeams = 0; // teams with all home games picked
+    uint64_t awayCompleteTeams = 0; // teams with all away games picked
+    std::array<std::array<uint8_t, 2>, MAX_TEAMS>
+        blockedPotsByTeamIndLocation{}; // [team ind][HOME/AWAY] -> pots team
+                                        // can no longer play at location
+    std::array<std::array<uint64_t, 2>, MAX_POTS>
+        blockedTeamsByPotLocation{}; // [pot][HOME/AWAY] -> teams which can no
+                                     // longer play pot at location
+    std::array<uint64_t, MAX_TEAMS>
+        maxedOppsByTeamInd{}; // team ind -> teams from countries it has
+                              // already faced twice
+    std::array<uint64_t, MAX_COUNTRIES>
+        maxedTeamsByCountry{}; // country -> teams which have already faced
+                               // country twice
+
+    // flow networks, maintained by Draw::dfsFlowCheck
+    std::array<uint64_t, MAX_TEAMS>
+        homeFlowByTeamInd{}; // team ind -> opps routed to team at home in its
+                             // pot group's network
+    std::array<uint64_t, MAX_TEAMS>
+        awayFlowByTeamInd{}; // team ind -> opps routed to team away in its
+                             // pot group's network
+};
+static_assert(std::is_trivially_copyable_v<DFSContext>,
+              "DFSContext must be copyable with memcpy");
+
+// undo log of DFSContext field writes, used to backtrack DFS by unwinding to
+// a saved mark instead of recomputing the reverted state
+// - entries point into a single DFSContext, which must not move while they
+//   are on the trail
+struct DFSTrail {
+    struct Entry {
+        void *field;
+        uint64_t oldValue;
+        uint8_t size;
+    };
+    std::vector<Entry> entries;
+
+    size_t mark() const { return entries.size(); }
+
+    // record field's old value (if changing), then overwrite it
+    template <typename T, typename V> void set(T &field, V value) {
+        static_assert(std::is_integral_v<T> && sizeof(T) <= sizeof(uint64_t),
+                      "DFSTrail only records integral fields");
+        if (field != static_cast<T>(value)) {
+            entries.push_back({&field, static_cast<uint64_t>(field),
+                               static_cast<uint8_t>(sizeof(T))});
+            field = static_cast<T>(value);
+        }
+    }
+
+    // restore every field written since mark, newest first
+    void undo(size_t mark) {
+        while (entries.size() > mark) {
+            const Entry &e = entries.back();
+            switch (e.size) {
+            case 1:
+                *static_cast<uint8_t *>(e.field) =
+                    static_cast<uint8_t>(e.oldValue);
+                break;
+            case 2:
+                *static_cast<uint16_t *>(e.field) =
+                    static_cast<uint16_t>(e.oldValue);
+                break;
+            case 4:
+                *static_cast<uint32_t *>(e.field) =
+                    static_cast<uint32_t>(e.oldValue);
+                break;
+            case 8:
+                *static_cast<uint64_t *>(e.field) = e.oldValue;
+                break;
+            }
+            entries.pop_back();
+        }
+    }
 };
 
 #endif // GLOBALS_H
\ No newline at end of file